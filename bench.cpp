@@ -0,0 +1,275 @@
+#include "history.h"
+#include "latency.h"
+#include "search.h"
+#include "tools.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <vector>
+
+// Narrow-phase benchmark (game --bench-collisions [shots])
+//
+// Records the ball layout at every step of a set of random break shots, then runs both
+// handleBallCollisionsScalar() and handleBallCollisions() on each layout, checks that they
+// agree bit for bit and reports the time per call.
+int runCollisionBenchmark(int argc, char** argv) {
+    int shotCount = argc > 2 ? std::max(1, atoi(argv[2])) : 200;
+
+    std::vector<std::vector<Ball>> layouts;
+    GameState g;
+    srand(12345);
+    for (int shot = 0; shot < shotCount; shot++) {
+        initializeGame(g);
+        float angle = PI + ((float)rand() / RAND_MAX - 0.5f) * 0.2f;
+        float power = g.maxCuePower * (0.5f + 0.5f * (float)rand() / RAND_MAX);
+        applyShot(g, angle, power);
+        for (int step = 0; step < MAX_SHOT_STEPS && g.ballsMoving && !g.gameOver; step++) {
+            layouts.push_back(g.balls);
+            update(g);
+        }
+    }
+
+    GameState scalar = g, vector = g;
+    size_t mismatches = 0;
+    for (const std::vector<Ball>& layout : layouts) {
+        scalar.balls = layout;
+        vector.balls = layout;
+        handleBallCollisionsScalar(scalar);
+        handleBallCollisions(vector);
+        if (memcmp(scalar.balls.data(), vector.balls.data(), layout.size() * sizeof(Ball)) != 0) mismatches++;
+    }
+
+    // Replay cache-sized blocks of layouts several times so memory bandwidth does not mask the kernels
+    const size_t blockSize = 256;
+    const int rounds = 20;
+    double seconds[2] = {};
+    for (int variant = 0; variant < 2; variant++) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (size_t block = 0; block < layouts.size(); block += blockSize) {
+            size_t blockEnd = std::min(block + blockSize, layouts.size());
+            for (int round = 0; round < rounds; round++) {
+                for (size_t k = block; k < blockEnd; k++) {
+                    g.balls.assign(layouts[k].begin(), layouts[k].end());
+                    if (variant == 0) handleBallCollisionsScalar(g);
+                    else handleBallCollisions(g);
+                }
+            }
+        }
+        seconds[variant] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    double calls = (double)layouts.size() * rounds;
+    std::cout << layouts.size() << " layouts from " << shotCount << " shots, kernel: " << (cpuHasAvx2 ? "AVX2" : "scalar") << "\n"
+              << "scalar loop: " << seconds[0] / calls * 1e9 << " ns/call\n"
+              << "contact mask: " << seconds[1] / calls * 1e9 << " ns/call (" << seconds[0] / seconds[1] << "x)\n"
+              << "mismatching layouts: " << mismatches << std::endl;
+    return mismatches == 0 ? 0 : 1;
+}
+
+// Mid-game tables for the benchmarks: a fresh rack after a few random shots, none of them finished
+std::vector<GameState> benchmarkTables(int tableCount) {
+    std::vector<GameState> tables;
+    GameState g;
+    srand(4242);
+    while ((int)tables.size() < tableCount) {
+        initializeGame(g);
+        int shots = 2 + rand() % 6;
+        for (int shot = 0; shot < shots && !g.gameOver; shot++) {
+            float angle = shot == 0 ? PI + ((float)rand() / RAND_MAX - 0.5f) * 0.2f : 2.0f * PI * rand() / RAND_MAX;
+            applyShot(g, angle, g.maxCuePower * (0.5f + 0.5f * (float)rand() / RAND_MAX));
+            simulateToRest(g, MAX_SHOT_STEPS);
+        }
+        if (!g.gameOver) tables.push_back(g);
+    }
+    return tables;
+}
+
+// Aim benchmark (game --bench-aim [tables])
+//
+// Builds a set of mid-game tables from a few random shots each and asks both the ghost-ball
+// solver and the old angle/power sampler for a shot on each, reporting the decision time
+// and how often the chosen shot pots one of the shooter's balls without a foul. Tables where
+// the solver finds no clean pot fall back to the blind search, so they are reported separately,
+// and so is the solver on its own.
+int runAimBenchmark(int argc, char** argv) {
+    int tableCount = argc > 2 ? std::max(1, atoi(argv[2])) : 50;
+    std::vector<GameState> tables = benchmarkTables(tableCount);
+
+    const char* names[2] = { "ghost-ball solver", "angle/power sampler" };
+    for (int variant = 0; variant < 2; variant++) {
+        int potted = 0;
+        int solved = 0;
+        double seconds = 0.0;
+        double solvedSeconds = 0.0;
+        for (const GameState& table : tables) {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            ShotRecord shot = variant == 0 ? chooseComputerShot(table) : chooseShotBySampling(table);
+            double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            seconds += elapsed;
+            if (variant == 0 && !findGhostBallShots(table).empty()) {
+                solved++;
+                solvedSeconds += elapsed;
+            }
+
+            GameState result = table;
+            applyShot(result, shot.cueAngle, shot.cuePower);
+            simulateToRest(result, MAX_SHOT_STEPS);
+            if (scoreShotOutcome(table, result) > 0.0f) potted++;
+        }
+        std::cout << names[variant] << ": " << seconds / tables.size() * 1e3 << " ms/decision, "
+                  << potted << "/" << tables.size() << " tables scored" << std::endl;
+        if (variant == 0) {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            size_t found = 0;
+            for (const GameState& table : tables) found += findGhostBallShots(table).size();
+            double solveSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            std::cout << "  " << solved << " tables had a clean pot: " << (solved ? solvedSeconds / solved * 1e3 : 0.0)
+                      << " ms/decision on those\n"
+                      << "  solver alone: " << solveSeconds / tables.size() * 1e6 << " us/table (" << found << " candidates)" << std::endl;
+        }
+    }
+    return 0;
+}
+
+// Two-tier search benchmark (game --bench-coarse [tables] [angles] [powers] [keep])
+//
+// On mid-game tables (as --bench-aim builds them), picks a shot from the same grid of angles and
+// powers twice: simulating every candidate with update(), and ranking them all with the coarse
+// tier so only the best few get the precise run. Reports decision latency, simulation steps,
+// how well the coarse tier agrees with update() (outcome and final positions) and how good the
+// two-tier pick is.
+int runCoarseBenchmark(int argc, char** argv) {
+    int tableCount = argc > 2 ? std::max(1, atoi(argv[2])) : 10;
+    int angleSteps = argc > 3 ? std::max(1, atoi(argv[3])) : 360;
+    int powerSteps = argc > 4 ? std::max(1, atoi(argv[4])) : 6;
+    size_t keep = argc > 5 ? (size_t)std::max(1, atoi(argv[5])) : 8;
+    std::vector<GameState> tables = benchmarkTables(tableCount);
+
+    double preciseSeconds = 0.0, twoTierSeconds = 0.0;
+    uint64_t preciseSteps = 0, coarseSteps = 0, coarsePasses = 0;
+    uint64_t candidates = 0, agreeing = 0, closeFinish = 0;
+    double gapSum = 0.0;
+    int matched = 0;
+    float scoreLost = 0.0f;
+    GameState precise, coarse;
+    for (const GameState& table : tables) {
+        // Always-precise: every candidate through update()
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        float bestScore = -1e9f;
+        for (int a = 0; a < angleSteps; a++) {
+            for (int p = 1; p <= powerSteps; p++) {
+                precise = table;
+                applyShot(precise, a * 2.0f * PI / angleSteps, table.maxCuePower * p / powerSteps);
+                preciseSteps += simulateToRest(precise, MAX_SHOT_STEPS);
+                bestScore = std::max(bestScore, scoreShotOutcome(table, precise));
+            }
+        }
+        preciseSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        start = std::chrono::steady_clock::now();
+        ShotRecord shot = chooseShotByCoarseRanking(table, angleSteps, powerSteps, keep);
+        twoTierSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        precise = table;
+        applyShot(precise, shot.cueAngle, shot.cuePower);
+        simulateToRest(precise, MAX_SHOT_STEPS);
+        float score = scoreShotOutcome(table, precise);
+        if (score >= bestScore) matched++;
+        scoreLost += bestScore - score;
+
+        // Tier agreement, candidate by candidate (outside the timings)
+        for (int a = 0; a < angleSteps; a++) {
+            for (int p = 1; p <= powerSteps; p++) {
+                float angle = a * 2.0f * PI / angleSteps, power = table.maxCuePower * p / powerSteps;
+                precise = table;
+                applyShot(precise, angle, power);
+                simulateToRest(precise, MAX_SHOT_STEPS);
+                coarse = table;
+                applyShot(coarse, angle, power);
+                CoarseResult result = simulateCoarse(coarse, MAX_SHOT_STEPS);
+                coarseSteps += result.steps;
+                coarsePasses += result.passes;
+                candidates++;
+                if (scoreShotOutcome(table, coarse) == scoreShotOutcome(table, precise)) agreeing++;
+
+                float worst = 0.0f;
+                for (int i = 0; i < NUM_BALLS; i++) {
+                    if (!coarse.balls[i].active || !precise.balls[i].active) continue;
+                    worst = std::max(worst, std::hypot(coarse.balls[i].x - precise.balls[i].x, coarse.balls[i].y - precise.balls[i].y));
+                }
+                gapSum += worst;
+                if (worst <= coarse.balls[0].radius) closeFinish++;
+            }
+        }
+    }
+
+    std::cout << tables.size() << " tables x " << angleSteps * powerSteps << " candidates, top " << keep << " re-run precisely\n"
+              << "always precise: " << preciseSeconds / tables.size() * 1e3 << " ms/decision, "
+              << (double)preciseSteps / candidates << " steps/candidate\n"
+              << "two-tier:       " << twoTierSeconds / tables.size() * 1e3 << " ms/decision ("
+              << preciseSeconds / twoTierSeconds << "x), " << (double)coarseSteps / candidates << " steps in "
+              << (double)coarsePasses / candidates << " passes/candidate coarse\n"
+              << "coarse outcome matches update(): " << 100.0 * agreeing / candidates << "% of candidates\n"
+              << "every ball finishing within a radius of update(): " << 100.0 * closeFinish / candidates
+              << "% of candidates (mean largest gap " << gapSum / candidates << ")\n"
+              << "two-tier pick as good as the exhaustive best: " << matched << "/" << tables.size() << " tables (mean score lost "
+              << scoreLost / tables.size() << ")" << std::endl;
+    return 0;
+}
+
+// Rewind history benchmark (game --bench-history [shots])
+//
+// Plays random shots with every step going into a 4 MB GameHistory, keeps full copies of a
+// sample of entries on the side, then restores random held entries, checks them against the
+// copies and reports the restore time and memory per entry.
+int runHistoryBenchmark(int argc, char** argv) {
+    int shotCount = argc > 2 ? std::max(1, atoi(argv[2])) : 500;
+
+    GameHistory steps(4 << 20, 1 << 16);
+    std::map<uint64_t, TableImage> samples;
+    RandomPlay play(99);
+    std::mt19937& random = play.random;
+
+    GameState g;
+    initializeGame(g);
+    uint64_t recorded = 0;
+    for (int shot = 0; shot < shotCount; shot++) {
+        play.playShot(g, [&](const GameState& table) { steps.record(table, true); }, [&](const GameState& table) {
+            uint64_t id = steps.record(table, false);
+            if (random() % 64 == 0) saveImage(table, samples[id]);
+        });
+    }
+    recorded = steps.end();
+
+    // Restore every sampled entry still held, in random order
+    std::vector<uint64_t> held;
+    for (const std::pair<const uint64_t, TableImage>& sample : samples) {
+        if (sample.first >= steps.first()) held.push_back(sample.first);
+    }
+    std::shuffle(held.begin(), held.end(), random);
+    LatencyHistogram restoreNanos;
+    size_t mismatches = 0;
+    GameState restored = g;
+    TableImage image;
+    for (uint64_t id : held) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        steps.restore(id, restored);
+        restoreNanos.record((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+        saveImage(restored, image);
+        if (memcmp(&image, &samples[id], sizeof(image)) != 0) mismatches++;
+    }
+
+    size_t heldEntries = (size_t)(steps.end() - steps.first());
+    size_t copyBytes = sizeof(GameState) + NUM_BALLS * sizeof(Ball) + NUM_POCKETS * sizeof(Pocket);
+    std::cout << recorded << " entries from " << shotCount << " shots, " << heldEntries << " held in "
+              << steps.bytesUsed() / 1024 << " KB of " << steps.capacityBytes() / 1024 << " KB ("
+              << (double)steps.bytesUsed() / heldEntries << " bytes/entry; a GameState copy is " << copyBytes << ")\n"
+              << "restore: p50 " << restoreNanos.percentile(50) << "ns  p99 " << restoreNanos.percentile(99)
+              << "ns  max " << restoreNanos.max() << "ns over " << held.size() << " entries, " << mismatches << " mismatching" << std::endl;
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,553 @@
+#include "tools.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Physics calibration (game --calibrate FILE ... and game --record-reference FILE ...)
+//
+// A reference file holds shots tracked on a real table: the starting layout, the shot, and where
+// every ball was at a number of simulation steps (60 Hz) after it. --calibrate looks for the
+// PhysicsParams whose simulation best matches them: over longer and longer stretches of the shots,
+// a grid over CALIBRATION_RANGES evaluated on every core, then line scans and finer and finer
+// grids around the best few cells, the last stretch's best and the current parameters, which it
+// only reports beaten by a better fit. --record-reference writes the same format from this
+// simulator (optionally with tracking noise and other parameters), so a sweep can be checked
+// against parameters it should recover.
+//
+// Once several object balls are moving, every small change to the parameters reorders later
+// collisions and the error jumps around. So each shot is only compared up to the frame before a
+// second object ball leaves its spot: the cue ball's roll, its cushions, the first contact and
+// the two balls after it, down to them stopping if nothing else is hit. Errors are also clipped
+// per ball, so one shot that goes a different way cannot outweigh the rest.
+//
+// Reference format (text, one block per shot; positions in table units, active 0/1):
+//   shot <cueAngle> <cuePower>
+//   start <x y active> for each of the 16 balls
+//   frame <step> <x y active> for each ball       (any number of frames, increasing step)
+//   end
+
+struct ReferenceFrame {
+    int step = 0;
+    float x[NUM_BALLS] = {};
+    float y[NUM_BALLS] = {};
+    bool active[NUM_BALLS] = {};
+};
+
+struct ReferenceShot {
+    float cueAngle = 0.0f;
+    float cuePower = 0.0f;
+    ReferenceFrame start;
+    std::vector<ReferenceFrame> frames;
+    size_t fitFrames = 0; // Frames before a second object ball moves, the ones --calibrate compares
+};
+
+struct CalibrationRange {
+    const char* name; // Also the command line option of --record-reference
+    float PhysicsParams::*field;
+    float low, high;
+    bool decay;     // Searched as log(1 - value): friction matters by how far a ball rolls, 1 / (1 - f)
+    int gridPoints; // Of the first, coarsest grid
+};
+
+// Friction has the narrowest dip (about 0.2 wide in log(1 - f)), so it is sampled much closer
+const CalibrationRange CALIBRATION_RANGES[] = {
+    { "friction", &PhysicsParams::friction, 0.995f, 0.9999f, true, 33 },
+    { "min-velocity", &PhysicsParams::minVelocity, 0.001f, 0.015f, false, 5 },
+    { "ball-elasticity", &PhysicsParams::ballElasticity, 0.0f, 1.0f, false, 5 },
+    { "cushion", &PhysicsParams::cushionRestitution, 0.3f, 1.0f, false, 5 },
+};
+const int CALIBRATION_PARAMS = sizeof(CALIBRATION_RANGES) / sizeof(CALIBRATION_RANGES[0]);
+
+// Best candidates of a stage refined alongside the current parameters
+const int CALIBRATION_STARTS = 4;
+
+// A start stops once its refining grid has shrunk to this fraction of a coarse cell
+const float CALIBRATION_FINEST = 1.0f / 1024.0f;
+
+// Refining grid, in coarse cells, that a stage starts the last stage's results from
+const float CALIBRATION_CARRIED_SCALE = 1.0f / 8.0f;
+
+// Points of the line scanned through every start along each range, ends included
+const int CALIBRATION_LINE_POINTS = 257;
+
+// Steps of each shot the first stage compares; every later stage doubles it
+const int CALIBRATION_FIRST_HORIZON = 60;
+
+// A fitted value is kept only if going back to the current one costs more than this factor
+const double CALIBRATION_UNCONSTRAINED = 1.01;
+
+// A ball further than this from its starting spot has been hit (well above tracking noise)
+const float REFERENCE_MOVED = 0.01f;
+
+// Squared error at which one ball in one frame stops counting for more; a ball pocketed in one
+// trajectory and not the other is charged the same
+const float CALIBRATION_CLIP = 0.01f;
+
+void captureFrame(const GameState& g, int step, ReferenceFrame& frame) {
+    frame.step = step;
+    for (int i = 0; i < NUM_BALLS; i++) {
+        frame.x[i] = g.balls[i].x;
+        frame.y[i] = g.balls[i].y;
+        frame.active[i] = g.balls[i].active;
+    }
+}
+
+void writeFrame(std::ostream& out, const char* tag, const ReferenceFrame& frame, bool withStep) {
+    out << tag;
+    if (withStep) out << " " << frame.step;
+    for (int i = 0; i < NUM_BALLS; i++) out << " " << frame.x[i] << " " << frame.y[i] << " " << (frame.active[i] ? 1 : 0);
+    out << "\n";
+}
+
+bool readFrame(std::istringstream& line, ReferenceFrame& frame, bool withStep) {
+    if (withStep && !(line >> frame.step)) return false;
+    for (int i = 0; i < NUM_BALLS; i++) {
+        int active;
+        if (!(line >> frame.x[i] >> frame.y[i] >> active)) return false;
+        frame.active[i] = active != 0;
+    }
+    return true;
+}
+
+bool saveReferences(const std::string& path, const std::vector<ReferenceShot>& shots) {
+    std::ofstream out(path);
+    out.precision(9);
+    for (const ReferenceShot& shot : shots) {
+        out << "shot " << shot.cueAngle << " " << shot.cuePower << "\n";
+        writeFrame(out, "start", shot.start, false);
+        for (const ReferenceFrame& frame : shot.frames) writeFrame(out, "frame", frame, true);
+        out << "end\n";
+    }
+    return out.good();
+}
+
+// Frames of a shot before a second object ball has left its spot
+size_t fittedFrames(const ReferenceShot& shot) {
+    for (size_t f = 0; f < shot.frames.size(); f++) {
+        const ReferenceFrame& frame = shot.frames[f];
+        int moved = 0;
+        for (int i = 1; i < NUM_BALLS; i++) {
+            if (!shot.start.active[i]) continue;
+            float dx = frame.x[i] - shot.start.x[i], dy = frame.y[i] - shot.start.y[i];
+            if (!frame.active[i] || dx * dx + dy * dy > REFERENCE_MOVED * REFERENCE_MOVED) moved++;
+        }
+        if (moved > 1) return f;
+    }
+    return shot.frames.size();
+}
+
+bool loadReferences(const std::string& path, std::vector<ReferenceShot>& shots) {
+    std::ifstream in(path);
+    if (!in) return false;
+    std::string text;
+    ReferenceShot shot;
+    while (std::getline(in, text)) {
+        std::istringstream line(text);
+        std::string tag;
+        if (!(line >> tag)) continue;
+        bool good = true;
+        if (tag == "shot") {
+            shot = ReferenceShot();
+            good = (bool)(line >> shot.cueAngle >> shot.cuePower);
+        }
+        else if (tag == "start") good = readFrame(line, shot.start, false);
+        else if (tag == "frame") {
+            shot.frames.emplace_back();
+            good = readFrame(line, shot.frames.back(), true);
+        }
+        else if (tag == "end") {
+            shot.fitFrames = fittedFrames(shot);
+            shots.push_back(shot);
+        }
+        else good = false;
+        if (!good) {
+            std::cerr << "Bad reference line: " << text << std::endl;
+            return false;
+        }
+    }
+    return !shots.empty();
+}
+
+// Mean clipped squared position error of a simulation against the references, over every ball
+// in each shot's fitted frames up to horizon steps into the shot
+double trajectoryError(const std::vector<ReferenceShot>& shots, const PhysicsParams& physics, const GameState& rack, int horizon) {
+    double total = 0.0;
+    uint64_t samples = 0;
+    GameState g;
+    for (const ReferenceShot& shot : shots) {
+        g = rack;
+        g.physics = physics;
+        g.activeBalls = 0;
+        for (int i = 0; i < NUM_BALLS; i++) {
+            Ball& ball = g.balls[i];
+            ball.x = shot.start.x[i];
+            ball.y = shot.start.y[i];
+            ball.vx = ball.vy = 0.0f;
+            ball.active = shot.start.active[i];
+            if (ball.active) g.activeBalls++;
+        }
+        applyShot(g, shot.cueAngle, shot.cuePower);
+
+        // Physics only: rules (game over on the black) must not freeze the table
+        int step = 0;
+        bool moving = true;
+        for (size_t f = 0; f < shot.fitFrames && shot.frames[f].step <= horizon; f++) {
+            const ReferenceFrame& frame = shot.frames[f];
+            for (; moving && step < frame.step; step++) {
+                advanceBalls(g);
+                moving = !allBallsStopped(g);
+            }
+            for (int i = 0; i < NUM_BALLS; i++) {
+                if (frame.active[i] != g.balls[i].active) total += CALIBRATION_CLIP;
+                else if (frame.active[i]) {
+                    float dx = g.balls[i].x - frame.x[i], dy = g.balls[i].y - frame.y[i];
+                    total += std::min(dx * dx + dy * dy, CALIBRATION_CLIP);
+                }
+                samples++;
+            }
+        }
+    }
+    return samples > 0 ? total / samples : 0.0;
+}
+
+// Evaluate every candidate, spreading them over the threads
+std::vector<double> evaluateCandidates(const std::vector<PhysicsParams>& candidates, const std::vector<ReferenceShot>& shots,
+                                       const GameState& rack, int horizon, int threadCount) {
+    std::vector<double> errors(candidates.size());
+    std::atomic<size_t> next{0};
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threadCount; t++) {
+        workers.emplace_back([&] {
+            for (size_t i = next.fetch_add(1); i < candidates.size(); i = next.fetch_add(1)) {
+                errors[i] = trajectoryError(shots, candidates[i], rack, horizon);
+            }
+        });
+    }
+    for (std::thread& worker : workers) worker.join();
+    return errors;
+}
+
+// Search coordinate of a parameter value, and back
+float toSearch(const CalibrationRange& range, float value) {
+    return range.decay ? log(1.0f - value) : value;
+}
+
+float fromSearch(const CalibrationRange& range, float coordinate) {
+    return range.decay ? 1.0f - exp(coordinate) : coordinate;
+}
+
+void searchBounds(const CalibrationRange& range, float& low, float& high) {
+    low = std::min(toSearch(range, range.low), toSearch(range, range.high));
+    high = std::max(toSearch(range, range.low), toSearch(range, range.high));
+}
+
+// Every point of a grid, centre +- halfWidth along each axis, clamped to the ranges
+void addGrid(const float* centre, const float* halfWidth, const int* points, std::vector<PhysicsParams>& candidates) {
+    int cells = 1;
+    for (int p = 0; p < CALIBRATION_PARAMS; p++) cells *= points[p];
+    for (int cell = 0; cell < cells; cell++) {
+        PhysicsParams physics;
+        for (int p = 0, rest = cell; p < CALIBRATION_PARAMS; rest /= points[p], p++) {
+            const CalibrationRange& range = CALIBRATION_RANGES[p];
+            float low, high;
+            searchBounds(range, low, high);
+            float coordinate = centre[p] + halfWidth[p] * (2.0f * (rest % points[p]) / (points[p] - 1) - 1.0f);
+            physics.*range.field = fromSearch(range, std::max(low, std::min(coordinate, high)));
+        }
+        candidates.push_back(physics);
+    }
+}
+
+void printPhysics(const char* label, const PhysicsParams& physics, double error) {
+    std::cout << label;
+    for (const CalibrationRange& range : CALIBRATION_RANGES) std::cout << " " << range.name << "=" << physics.*range.field;
+    std::cout << "  rms error " << sqrt(error) << std::endl;
+}
+
+int runCalibration(int argc, char** argv) {
+    std::string path;
+    int threadCount = (int)std::max(1u, std::thread::hardware_concurrency());
+    int rounds = 100;
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc) threadCount = std::max(1, atoi(argv[++i]));
+        else if (arg == "--rounds" && i + 1 < argc) rounds = std::max(0, atoi(argv[++i]));
+        else if (path.empty() && arg[0] != '-') path = arg;
+        else {
+            path.clear();
+            break;
+        }
+    }
+    if (path.empty()) {
+        std::cerr << "Usage: " << argv[0] << " --calibrate REFERENCE_FILE [--threads N] [--rounds N]" << std::endl;
+        return 2;
+    }
+    std::vector<ReferenceShot> shots;
+    if (!loadReferences(path, shots)) {
+        std::cerr << "Could not load reference trajectories from " << path << std::endl;
+        return 1;
+    }
+    size_t fitted = 0, frames = 0;
+    for (const ReferenceShot& shot : shots) {
+        fitted += shot.fitFrames;
+        frames += shot.frames.size();
+    }
+
+    GameState rack;
+    initializeGame(rack);
+    tableField();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    uint64_t evaluations = 0;
+
+    int longest = 0;
+    for (const ReferenceShot& shot : shots) {
+        if (shot.fitFrames > 0) longest = std::max(longest, shot.frames[shot.fitFrames - 1].step);
+    }
+
+    // Coarse to fine, in time and in the parameters. Each stage compares a longer stretch of every
+    // shot, starting with the first second and doubling: how far a ball rolls pins friction down
+    // ever more tightly, so a dip that is wide over the first second is a sliver over a whole
+    // shot, and parameters like the cushion only come into view later. A stage evaluates the
+    // whole coarse grid plus the current parameters and the previous stage's results, then
+    // refines the best few with a 3-point grid, moved to its best point and halved only when the
+    // centre stays best (dips are narrow valleys across the parameters, which a grid shrinking
+    // every round would stall in).
+    const PhysicsParams current;
+    float centre[CALIBRATION_PARAMS], halfWidth[CALIBRATION_PARAMS], cell[CALIBRATION_PARAMS];
+    int gridPoints[CALIBRATION_PARAMS], refinePoints[CALIBRATION_PARAMS];
+    size_t refineCells = 1;
+    for (int p = 0; p < CALIBRATION_PARAMS; p++) {
+        float low, high;
+        searchBounds(CALIBRATION_RANGES[p], low, high);
+        centre[p] = (low + high) / 2.0f;
+        halfWidth[p] = (high - low) / 2.0f;
+        gridPoints[p] = CALIBRATION_RANGES[p].gridPoints;
+        cell[p] = (high - low) / (gridPoints[p] - 1);
+        refinePoints[p] = 3;
+        refineCells *= refinePoints[p];
+    }
+    std::vector<PhysicsParams> grid;
+    addGrid(centre, halfWidth, gridPoints, grid);
+
+    std::vector<PhysicsParams> starts;
+    std::vector<double> startErrors;
+    for (int horizon = std::min(CALIBRATION_FIRST_HORIZON, longest);; horizon = std::min(horizon * 2, longest)) {
+        std::vector<PhysicsParams> candidates = { current };
+        candidates.insert(candidates.end(), starts.begin(), starts.end());
+        size_t carried = candidates.size();
+        candidates.insert(candidates.end(), grid.begin(), grid.end());
+        std::vector<double> errors = evaluateCandidates(candidates, shots, rack, horizon, threadCount);
+        evaluations += candidates.size();
+
+        // Always the current parameters, then the best few of the last stage's and the grid's,
+        // each only once. What the last stage found is refined from a narrower grid so it stays
+        // in its dip: a longer stretch makes the dip narrower, it does not move it.
+        std::vector<size_t> order(candidates.size() - 1);
+        for (size_t i = 0; i < order.size(); i++) order[i] = i + 1;
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return errors[a] < errors[b]; });
+        starts = { current };
+        startErrors = { errors[0] };
+        std::vector<float> scales = { 1.0f }; // Of the refining grid in coarse cells, per start
+        for (size_t i = 0; i < order.size() && (int)starts.size() <= CALIBRATION_STARTS; i++) {
+            const PhysicsParams& candidate = candidates[order[i]];
+            bool seen = false;
+            for (const PhysicsParams& other : starts) {
+                bool same = true;
+                for (int p = 0; p < CALIBRATION_PARAMS; p++) same &= candidate.*CALIBRATION_RANGES[p].field == other.*CALIBRATION_RANGES[p].field;
+                seen |= same;
+            }
+            if (seen) continue;
+            starts.push_back(candidate);
+            startErrors.push_back(errors[order[i]]);
+            scales.push_back(order[i] < carried ? CALIBRATION_CARRIED_SCALE : 1.0f);
+        }
+
+        // Each start first moves to the best point on a fine line through it along every range:
+        // stopping at a whole step makes the error flat across most of min-velocity, with the right
+        // value in a narrow dip, which only a scan this fine finds
+        candidates.clear();
+        for (const PhysicsParams& physics : starts) {
+            for (int p = 0; p < CALIBRATION_PARAMS; p++) {
+                float low, high;
+                searchBounds(CALIBRATION_RANGES[p], low, high);
+                for (int i = 0; i < CALIBRATION_LINE_POINTS; i++) {
+                    candidates.push_back(physics);
+                    candidates.back().*CALIBRATION_RANGES[p].field = fromSearch(CALIBRATION_RANGES[p], low + (high - low) * i / (CALIBRATION_LINE_POINTS - 1));
+                }
+            }
+        }
+        errors = evaluateCandidates(candidates, shots, rack, horizon, threadCount);
+        evaluations += candidates.size();
+        size_t lineCells = (size_t)CALIBRATION_PARAMS * CALIBRATION_LINE_POINTS;
+        for (size_t s = 0; s < starts.size(); s++) {
+            for (size_t i = s * lineCells; i < (s + 1) * lineCells; i++) {
+                if (errors[i] < startErrors[s]) {
+                    starts[s] = candidates[i];
+                    startErrors[s] = errors[i];
+                }
+            }
+        }
+
+        for (int round = 0; round < rounds; round++) {
+            std::vector<size_t> active;
+            candidates.clear();
+            for (size_t s = 0; s < starts.size(); s++) {
+                if (scales[s] < CALIBRATION_FINEST) continue;
+                float width[CALIBRATION_PARAMS];
+                for (int p = 0; p < CALIBRATION_PARAMS; p++) {
+                    centre[p] = toSearch(CALIBRATION_RANGES[p], starts[s].*CALIBRATION_RANGES[p].field);
+                    width[p] = cell[p] * scales[s];
+                }
+                addGrid(centre, width, refinePoints, candidates);
+                active.push_back(s);
+            }
+            if (active.empty()) break;
+            errors = evaluateCandidates(candidates, shots, rack, horizon, threadCount);
+            evaluations += candidates.size();
+            for (size_t a = 0; a < active.size(); a++) {
+                size_t s = active[a];
+                bool moved = false;
+                for (size_t i = a * refineCells; i < (a + 1) * refineCells; i++) {
+                    if (errors[i] < startErrors[s]) {
+                        starts[s] = candidates[i];
+                        startErrors[s] = errors[i];
+                        moved = true;
+                    }
+                }
+                if (!moved) scales[s] /= 2.0f;
+            }
+        }
+        if (horizon >= longest) break;
+    }
+    double currentError = trajectoryError(shots, current, rack, longest);
+    size_t winner = std::min_element(startErrors.begin(), startErrors.end()) - startErrors.begin();
+    PhysicsParams best = startErrors[winner] < currentError ? starts[winner] : current;
+    double bestError = std::min(startErrors[winner], currentError);
+
+    // A parameter the shots say nothing about (say, ball elasticity when every first contact
+    // sets several balls moving at once) keeps its current value instead of an arbitrary one
+    bool constrained[CALIBRATION_PARAMS];
+    for (int p = 0; p < CALIBRATION_PARAMS; p++) {
+        const CalibrationRange& range = CALIBRATION_RANGES[p];
+        constrained[p] = false;
+        for (int sign = -1; sign <= 1; sign += 2) {
+            float low, high;
+            searchBounds(range, low, high);
+            float coordinate = toSearch(range, best.*range.field) + sign * cell[p] / 4.0f;
+            PhysicsParams trial = best;
+            trial.*range.field = fromSearch(range, std::max(low, std::min(coordinate, high)));
+            constrained[p] |= trajectoryError(shots, trial, rack, longest) > bestError * CALIBRATION_UNCONSTRAINED + 1e-12;
+            evaluations++;
+        }
+        if (!constrained[p]) {
+            PhysicsParams trial = best;
+            trial.*range.field = current.*range.field;
+            double error = trajectoryError(shots, trial, rack, longest);
+            evaluations++;
+            if (error <= bestError * CALIBRATION_UNCONSTRAINED + 1e-12) {
+                best = trial;
+                bestError = error;
+            }
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printPhysics("current:  ", current, currentError);
+    printPhysics("fitted:   ", best, bestError);
+    if (bestError >= currentError) std::cout << "(nothing fits better than the current parameters)" << std::endl;
+    for (int p = 0; p < CALIBRATION_PARAMS; p++) {
+        if (!constrained[p]) std::cout << "(" << CALIBRATION_RANGES[p].name << " is hardly constrained by these shots)" << std::endl;
+    }
+    std::cout << shots.size() << " reference shots (" << fitted << " of " << frames << " frames compared), " << evaluations
+              << " evaluations on " << threadCount << " threads in " << seconds << " s (" << evaluations / seconds << " evaluations/s)"
+              << std::endl;
+    return 0;
+}
+
+int runRecordReference(int argc, char** argv) {
+    std::string path;
+    int shotCount = 20;
+    int every = 10;
+    float noise = 0.0f;
+    unsigned seed = 1;
+    PhysicsParams physics;
+    bool good = true;
+    for (int i = 2; i < argc && good; i++) {
+        std::string arg = argv[i];
+        bool matched = false;
+        for (const CalibrationRange& range : CALIBRATION_RANGES) {
+            if (arg == std::string("--") + range.name && i + 1 < argc) {
+                physics.*range.field = (float)atof(argv[++i]);
+                matched = true;
+            }
+        }
+        if (matched) continue;
+        if (arg == "--shots" && i + 1 < argc) shotCount = std::max(1, atoi(argv[++i]));
+        else if (arg == "--every" && i + 1 < argc) every = std::max(1, atoi(argv[++i]));
+        else if (arg == "--noise" && i + 1 < argc) noise = (float)atof(argv[++i]);
+        else if (arg == "--seed" && i + 1 < argc) seed = (unsigned)strtoul(argv[++i], nullptr, 10);
+        else if (path.empty() && arg[0] != '-') path = arg;
+        else good = false;
+    }
+    if (!good || path.empty()) {
+        std::cerr << "Usage: " << argv[0] << " --record-reference FILE [--shots N] [--every STEPS] [--noise SIGMA] [--seed N]";
+        for (const CalibrationRange& range : CALIBRATION_RANGES) std::cerr << " [--" << range.name << " X]";
+        std::cerr << std::endl;
+        return 2;
+    }
+
+    RandomPlay play(seed, 0.3f);
+    std::mt19937& random = play.random;
+    std::normal_distribution<float> tracking(0.0f, noise > 0.0f ? noise : 1.0f);
+
+    // Random games, so the shots cover breaks, open tables and cushion play. Steps go through
+    // advanceBalls() rather than update(): the rules must not stop the balls on a potted black.
+    std::vector<ReferenceShot> shots;
+    GameState g;
+    initializeGame(g);
+    g.physics = physics;
+    while ((int)shots.size() < shotCount) {
+        play.continueGame(g);
+        ReferenceShot shot;
+        captureFrame(g, 0, shot.start);
+        ShotRecord played = shots.empty() ? play.shoot(g, PI) : play.shoot(g);
+        shot.cueAngle = played.cueAngle;
+        shot.cuePower = played.cuePower;
+
+        int step = 0;
+        for (bool moving = true; moving && step < MAX_SHOT_STEPS;) {
+            advanceBalls(g);
+            step++;
+            moving = !allBallsStopped(g);
+            if (step % every == 0 || !moving) {
+                shot.frames.emplace_back();
+                captureFrame(g, step, shot.frames.back());
+                if (noise > 0.0f) {
+                    for (int i = 0; i < NUM_BALLS; i++) {
+                        shot.frames.back().x[i] += tracking(random);
+                        shot.frames.back().y[i] += tracking(random);
+                    }
+                }
+            }
+        }
+        finishShot(g);
+        shots.push_back(shot);
+
+        // The next shot starts from rest, as the reference format has no velocities
+        for (Ball& ball : g.balls) ball.vx = ball.vy = 0.0f;
+    }
+    if (!saveReferences(path, shots)) {
+        std::cerr << "Could not write " << path << std::endl;
+        return 1;
+    }
+    return 0;
+}
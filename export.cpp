@@ -0,0 +1,546 @@
+#include "tools.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Training data export (game --export [--shots N] [--threads N] [--seed N] [--chunk ROWS] [--out PREFIX])
+//
+// Plays random shots in random games on every core and writes one row per shot: the table before
+// the shot, the shot itself and what it potted. Each column goes to its own PREFIX_<name>.col in
+// chunks of --chunk rows, and chunk k of every column holds the same rows. Integer chunks are
+// frame-of-reference bit-packed, and when that is smaller, run-length coded through a bitmap
+// (most balls do not move between consecutive shots of a game). Either way a reader that mmaps
+// a file reaches any value with shifts, masks and a popcount, and never parses anything.
+// Workers pack whole chunks themselves and only take the file lock to append the finished bytes.
+//
+// File layout (little endian):
+//   "POOLCOL1"
+//   chunk payloads, each a whole number of u64 words
+//   directory: one ColumnChunk per chunk
+//   footer: ColumnFooter
+// Element j * rows + r of a chunk is value j of its row r. field(k) below is the bits-wide value
+// at bit k * bits of a packed array, and every integer value is reference + field(k).
+//   ENCODING_PACKED: the payload is one packed array and k = element.
+//   ENCODING_RUNS: the payload is a bitmap with a bit set on every element that starts a run
+//   (ceil(n / 64) u64 words), then the number of set bits before each bitmap word (u32 each,
+//   padded to a u64), then the packed array of run values; k = set bits in bitmap[0..element] - 1.
+//   ENCODING_FLOAT32: the payload is the raw float32 values.
+//
+// Columns: ball_x, ball_y (16 per row, u16 across the table: 0 = left/bottom rail line,
+// 65535 = right/top, 0 for pocketed balls), active (bit i = ball i on the table), current_player,
+// ball_type_assigned, cue_angle, cue_power (float32), potted (GameState::pottedMask, bit 0 = cue
+// ball), foul (scratch, or the black potted early).
+
+const char COLUMN_MAGIC[8] = { 'P', 'O', 'O', 'L', 'C', 'O', 'L', '1' };
+
+enum ColumnType : uint32_t { COLUMN_PACKED = 0, COLUMN_FLOAT32 = 1 };
+enum ColumnEncoding : uint32_t { ENCODING_PACKED = 0, ENCODING_RUNS = 1, ENCODING_FLOAT32 = 2 };
+
+struct ColumnSpec {
+    const char* name;
+    uint32_t valuesPerRow;
+    ColumnType type;
+    uint32_t plainBytes; // Per value in a plain fixed-width record, for the size report
+};
+
+enum ExportColumn { EXPORT_BALL_X, EXPORT_BALL_Y, EXPORT_ACTIVE, EXPORT_PLAYER, EXPORT_TYPE_ASSIGNED,
+                    EXPORT_CUE_ANGLE, EXPORT_CUE_POWER, EXPORT_POTTED, EXPORT_FOUL, EXPORT_COLUMN_COUNT };
+
+const ColumnSpec EXPORT_COLUMNS[EXPORT_COLUMN_COUNT] = {
+    { "ball_x", NUM_BALLS, COLUMN_PACKED, 2 },
+    { "ball_y", NUM_BALLS, COLUMN_PACKED, 2 },
+    { "active", 1, COLUMN_PACKED, 2 },
+    { "current_player", 1, COLUMN_PACKED, 1 },
+    { "ball_type_assigned", 1, COLUMN_PACKED, 1 },
+    { "cue_angle", 1, COLUMN_FLOAT32, 4 },
+    { "cue_power", 1, COLUMN_FLOAT32, 4 },
+    { "potted", 1, COLUMN_PACKED, 2 },
+    { "foul", 1, COLUMN_PACKED, 1 },
+};
+
+struct ColumnChunk {
+    uint64_t offset;    // Of the payload, from the start of the file
+    uint64_t reference; // Added to every packed value
+    uint32_t rows;
+    uint32_t bits;      // Per packed value; 0 when the whole chunk equals reference
+    uint32_t encoding;  // ColumnEncoding
+    uint32_t runs;      // Packed values in an ENCODING_RUNS chunk
+};
+
+struct ColumnFooter {
+    uint64_t directoryOffset;
+    uint64_t rows;
+    uint32_t chunks;
+    uint32_t valuesPerRow;
+    uint32_t type;
+    uint32_t reserved;
+    char magic[8];
+};
+
+// One chunk of one column, ready to append
+struct PackedColumn {
+    ColumnChunk chunk;
+    std::vector<uint64_t> words;
+};
+
+// Bits needed for values 0..range
+uint32_t bitsFor(uint32_t range) {
+    uint32_t bits = 0;
+    while (bits < 32 && ((uint64_t)range >> bits) != 0) bits++;
+    return bits;
+}
+
+// Append values - reference as a bits-wide packed array, starting on a fresh word
+void packBits(const std::vector<uint32_t>& values, uint32_t reference, uint32_t bits, std::vector<uint64_t>& words) {
+    size_t first = words.size();
+    words.resize(first + (values.size() * bits + 63) / 64, 0);
+    if (bits == 0) return;
+    for (size_t i = 0; i < values.size(); i++) {
+        uint64_t value = values[i] - reference;
+        size_t bit = i * bits;
+        words[first + bit / 64] |= value << (bit % 64);
+        if (bit % 64 + bits > 64) words[first + bit / 64 + 1] |= value >> (64 - bit % 64);
+    }
+}
+
+// Pack one chunk of one column; values arrive row-major and are stored value-major
+PackedColumn packColumn(const std::vector<uint32_t>& values, uint32_t rows, uint32_t valuesPerRow, ColumnType type) {
+    std::vector<uint32_t> elements(values.size());
+    for (uint32_t r = 0; r < rows; r++) {
+        for (uint32_t j = 0; j < valuesPerRow; j++) elements[(size_t)j * rows + r] = values[(size_t)r * valuesPerRow + j];
+    }
+
+    PackedColumn packed;
+    packed.chunk.offset = 0;
+    packed.chunk.rows = rows;
+    packed.chunk.runs = 0;
+    if (type == COLUMN_FLOAT32) {
+        packed.chunk.reference = 0;
+        packed.chunk.bits = 32;
+        packed.chunk.encoding = ENCODING_FLOAT32;
+        packed.words.assign((elements.size() + 1) / 2, 0);
+        memcpy(packed.words.data(), elements.data(), elements.size() * sizeof(uint32_t));
+        return packed;
+    }
+
+    uint32_t low = elements.empty() ? 0 : *std::min_element(elements.begin(), elements.end());
+    uint32_t high = elements.empty() ? 0 : *std::max_element(elements.begin(), elements.end());
+    uint32_t bits = bitsFor(high - low);
+    packed.chunk.reference = low;
+    packed.chunk.bits = bits;
+
+    // Runs of one value within each value's sequence of rows
+    std::vector<uint64_t> starts((elements.size() + 63) / 64, 0);
+    std::vector<uint32_t> runValues;
+    for (size_t e = 0; e < elements.size(); e++) {
+        if (e % rows == 0 || elements[e] != elements[e - 1]) {
+            starts[e / 64] |= 1ull << (e % 64);
+            runValues.push_back(elements[e]);
+        }
+    }
+    size_t plainWords = (elements.size() * bits + 63) / 64;
+    size_t rankWords = (starts.size() + 1) / 2;
+    size_t runWords = starts.size() + rankWords + (runValues.size() * bits + 63) / 64;
+
+    if (runWords < plainWords) {
+        packed.chunk.encoding = ENCODING_RUNS;
+        packed.chunk.runs = (uint32_t)runValues.size();
+        packed.words = starts;
+        std::vector<uint32_t> ranks(rankWords * 2, 0);
+        uint32_t seen = 0;
+        for (size_t w = 0; w < starts.size(); w++) {
+            ranks[w] = seen;
+            seen += (uint32_t)__builtin_popcountll(starts[w]);
+        }
+        packed.words.resize(starts.size() + rankWords);
+        memcpy(packed.words.data() + starts.size(), ranks.data(), ranks.size() * sizeof(uint32_t));
+        packBits(runValues, low, bits, packed.words);
+    }
+    else {
+        packed.chunk.encoding = ENCODING_PACKED;
+        packBits(elements, low, bits, packed.words);
+    }
+    return packed;
+}
+
+// Appends chunks to every column file; chunks from one call land at the same index in all files
+class ColumnWriter {
+public:
+    bool open(const std::string& prefix) {
+        for (int c = 0; c < EXPORT_COLUMN_COUNT; c++) {
+            files[c].open(prefix + "_" + EXPORT_COLUMNS[c].name + ".col", std::ios::binary);
+            files[c].write(COLUMN_MAGIC, sizeof(COLUMN_MAGIC));
+            offsets[c] = sizeof(COLUMN_MAGIC);
+            if (!files[c]) return false;
+        }
+        return true;
+    }
+
+    void append(std::vector<PackedColumn>& columns) {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (int c = 0; c < EXPORT_COLUMN_COUNT; c++) {
+            PackedColumn& column = columns[c];
+            column.chunk.offset = offsets[c];
+            files[c].write((const char*)column.words.data(), column.words.size() * sizeof(uint64_t));
+            offsets[c] += column.words.size() * sizeof(uint64_t);
+            directories[c].push_back(column.chunk);
+        }
+        rows += columns[0].chunk.rows;
+        bytes += sumPayload(columns);
+    }
+
+    bool close() {
+        bool good = true;
+        for (int c = 0; c < EXPORT_COLUMN_COUNT; c++) {
+            ColumnFooter footer = { offsets[c], rows, (uint32_t)directories[c].size(), EXPORT_COLUMNS[c].valuesPerRow,
+                                    (uint32_t)EXPORT_COLUMNS[c].type, 0, {} };
+            memcpy(footer.magic, COLUMN_MAGIC, sizeof(COLUMN_MAGIC));
+            files[c].write((const char*)directories[c].data(), directories[c].size() * sizeof(ColumnChunk));
+            files[c].write((const char*)&footer, sizeof(footer));
+            files[c].close();
+            good = good && !files[c].fail();
+        }
+        return good;
+    }
+
+    uint64_t rows = 0;
+    uint64_t bytes = 0;
+
+private:
+    static uint64_t sumPayload(const std::vector<PackedColumn>& columns) {
+        uint64_t total = 0;
+        for (const PackedColumn& column : columns) total += column.words.size() * sizeof(uint64_t);
+        return total;
+    }
+
+    std::mutex mutex;
+    std::ofstream files[EXPORT_COLUMN_COUNT];
+    uint64_t offsets[EXPORT_COLUMN_COUNT] = {};
+    std::vector<ColumnChunk> directories[EXPORT_COLUMN_COUNT];
+};
+
+// Rows a worker has simulated but not yet packed
+struct ShotRows {
+    std::vector<uint32_t> columns[EXPORT_COLUMN_COUNT];
+    uint32_t rows = 0;
+
+    // The shot is passed separately because finishShot() clears cuePower
+    void add(const GameState& before, const ShotRecord& shot, const GameState& after) {
+        uint32_t active = 0;
+        for (int i = 0; i < NUM_BALLS; i++) {
+            const Ball& ball = before.balls[i];
+            if (ball.active) active |= 1u << i;
+            columns[EXPORT_BALL_X].push_back(ball.active ? quantise(ball.x / before.tableWidth + 0.5f) : 0);
+            columns[EXPORT_BALL_Y].push_back(ball.active ? quantise(ball.y / before.tableHeight + 0.5f) : 0);
+        }
+        columns[EXPORT_ACTIVE].push_back(active);
+        columns[EXPORT_PLAYER].push_back((uint32_t)before.currentPlayer);
+        columns[EXPORT_TYPE_ASSIGNED].push_back(before.ballTypeAssigned ? 1 : 0);
+        columns[EXPORT_CUE_ANGLE].push_back(floatBits(shot.cueAngle));
+        columns[EXPORT_CUE_POWER].push_back(floatBits(shot.cuePower));
+        columns[EXPORT_POTTED].push_back(after.pottedMask);
+        bool lostOnBlack = after.gameOver && after.winner != before.currentPlayer;
+        columns[EXPORT_FOUL].push_back((after.pottedMask & 1u) || lostOnBlack ? 1 : 0);
+        rows++;
+    }
+
+    std::vector<PackedColumn> pack() const {
+        std::vector<PackedColumn> packed;
+        for (int c = 0; c < EXPORT_COLUMN_COUNT; c++) packed.push_back(packColumn(columns[c], rows, EXPORT_COLUMNS[c].valuesPerRow, EXPORT_COLUMNS[c].type));
+        return packed;
+    }
+
+    void clear() {
+        for (std::vector<uint32_t>& column : columns) column.clear();
+        rows = 0;
+    }
+
+private:
+    static uint32_t quantise(float unit) {
+        return (uint32_t)(std::max(0.0f, std::min(unit, 1.0f)) * 65535.0f + 0.5f);
+    }
+
+    static uint32_t floatBits(float value) {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+};
+
+struct ExportOptions {
+    long long shotCount = 1000000;
+    int threadCount = (int)std::max(1u, std::thread::hardware_concurrency());
+    unsigned seed = 1;
+    uint32_t chunkRows = 65536;
+    std::string prefix = "shots";
+};
+
+bool parseExportOptions(int argc, char** argv, ExportOptions& options) {
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--shots" && i + 1 < argc) options.shotCount = std::max(1LL, atoll(argv[++i]));
+        else if (arg == "--threads" && i + 1 < argc) options.threadCount = std::max(1, atoi(argv[++i]));
+        else if (arg == "--seed" && i + 1 < argc) options.seed = (unsigned)strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--chunk" && i + 1 < argc) options.chunkRows = (uint32_t)std::max(1, atoi(argv[++i]));
+        else if (arg == "--out" && i + 1 < argc) options.prefix = argv[++i];
+        else {
+            std::cerr << "Usage: " << argv[0] << " " << argv[1] << " [--shots N] [--threads N] [--seed N] [--chunk ROWS] [--out PREFIX]" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Worker t's share of the export, handed over a chunk at a time; the same options give the same chunks
+void playExportShots(const ExportOptions& options, const GameState& table, int t, const std::function<void(const ShotRows&)>& flush) {
+    long long share = options.shotCount / options.threadCount + (t < options.shotCount % options.threadCount ? 1 : 0);
+    RandomPlay play(options.seed * 7919u + (unsigned)t);
+    ShotRows rows;
+    GameState g = table;
+    GameState before;
+    for (long long shot = 0; shot < share; shot++) {
+        ShotRecord shotPlayed = play.playShot(g, [&](const GameState& table) { before = table; }, ignoreTable);
+        rows.add(before, shotPlayed, g);
+        if (rows.rows == options.chunkRows) {
+            flush(rows);
+            rows.clear();
+        }
+    }
+    if (rows.rows > 0) flush(rows);
+}
+
+int runExport(int argc, char** argv) {
+    ExportOptions options;
+    if (!parseExportOptions(argc, argv, options)) return 2;
+
+    ColumnWriter writer;
+    if (!writer.open(options.prefix)) {
+        std::cerr << "Could not create column files with prefix " << options.prefix << std::endl;
+        return 1;
+    }
+    GameState table;
+    initializeGame(table);
+    tableField();
+
+    std::atomic<uint64_t> packNanos{0};
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < options.threadCount; t++) {
+        workers.emplace_back([&, t] {
+            uint64_t nanos = 0;
+            playExportShots(options, table, t, [&](const ShotRows& rows) {
+                std::chrono::steady_clock::time_point packStart = std::chrono::steady_clock::now();
+                std::vector<PackedColumn> packed = rows.pack();
+                writer.append(packed);
+                nanos += (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - packStart).count();
+            });
+            packNanos.fetch_add(nanos, std::memory_order_relaxed);
+        });
+    }
+    for (std::thread& worker : workers) worker.join();
+    bool written = writer.close();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    uint32_t plainRowBytes = 0;
+    for (const ColumnSpec& column : EXPORT_COLUMNS) plainRowBytes += column.valuesPerRow * column.plainBytes;
+    double packSeconds = packNanos.load() / 1e9;
+    std::cout << writer.rows << " shots on " << options.threadCount << " threads in " << seconds << " s (" << writer.rows / seconds << " rows/s), "
+              << writer.bytes / 1e6 << " MB of column data (" << (double)writer.bytes / writer.rows << " bytes/row, "
+              << plainRowBytes << " unpacked); packing and writing took " << packSeconds / options.threadCount / seconds * 100.0
+              << "% of worker time" << std::endl;
+    if (!written) {
+        std::cerr << "Could not write column files with prefix " << options.prefix << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// Export check (game --verify-export, with the options the export ran with)
+//
+// Reads every PREFIX_<name>.col back through the layout above and plays the same shots again.
+// Workers append chunks in whatever order they finish, so each regenerated chunk is matched to
+// a chunk in the files by a hash of its rows, then compared value by value.
+
+struct ColumnFile {
+    std::vector<uint64_t> words; // The whole file
+    ColumnFooter footer;
+    const ColumnChunk* chunks = nullptr;
+};
+
+bool readColumnFile(const std::string& path, const ColumnSpec& spec, ColumnFile& file) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    std::streamoff size = in ? (std::streamoff)in.tellg() : -1;
+    if (size < (std::streamoff)(sizeof(COLUMN_MAGIC) + sizeof(ColumnFooter)) || size % sizeof(uint64_t) != 0) {
+        std::cerr << path << ": missing or truncated" << std::endl;
+        return false;
+    }
+    file.words.resize((size_t)size / sizeof(uint64_t));
+    in.seekg(0);
+    in.read((char*)file.words.data(), size);
+    memcpy(&file.footer, (const char*)file.words.data() + size - sizeof(ColumnFooter), sizeof(ColumnFooter));
+
+    const ColumnFooter& footer = file.footer;
+    uint64_t directoryEnd = footer.directoryOffset + (uint64_t)footer.chunks * sizeof(ColumnChunk);
+    if (memcmp(file.words.data(), COLUMN_MAGIC, sizeof(COLUMN_MAGIC)) != 0 || memcmp(footer.magic, COLUMN_MAGIC, sizeof(COLUMN_MAGIC)) != 0 ||
+        footer.valuesPerRow != spec.valuesPerRow || footer.type != (uint32_t)spec.type || footer.directoryOffset % sizeof(uint64_t) != 0 ||
+        directoryEnd != (uint64_t)size - sizeof(ColumnFooter)) {
+        std::cerr << path << ": not a " << spec.name << " column file" << std::endl;
+        return false;
+    }
+    file.chunks = (const ColumnChunk*)(file.words.data() + footer.directoryOffset / sizeof(uint64_t));
+    return true;
+}
+
+// field(k) of a bits-wide packed array
+uint64_t packedField(const uint64_t* words, size_t k, uint32_t bits) {
+    if (bits == 0) return 0;
+    size_t bit = k * bits;
+    uint64_t value = words[bit / 64] >> (bit % 64);
+    if (bit % 64 + bits > 64) value |= words[bit / 64 + 1] << (64 - bit % 64);
+    return bits == 64 ? value : value & ((1ull << bits) - 1);
+}
+
+// Chunk `index` of a column back into row-major values, as ShotRows holds them
+bool decodeColumnChunk(const ColumnFile& file, size_t index, std::vector<uint32_t>& values) {
+    const ColumnChunk& chunk = file.chunks[index];
+    size_t count = (size_t)chunk.rows * file.footer.valuesPerRow;
+    size_t bitmapWords = (count + 63) / 64;
+    size_t rankWords = (bitmapWords + 1) / 2;
+    size_t payloadWords;
+    if (chunk.encoding == ENCODING_FLOAT32) payloadWords = (count + 1) / 2;
+    else if (chunk.encoding == ENCODING_PACKED && chunk.bits <= 32) payloadWords = (count * chunk.bits + 63) / 64;
+    else if (chunk.encoding == ENCODING_RUNS && chunk.bits <= 32 && chunk.runs <= count) {
+        payloadWords = bitmapWords + rankWords + ((size_t)chunk.runs * chunk.bits + 63) / 64;
+    }
+    else return false;
+    if (chunk.offset % sizeof(uint64_t) != 0 || chunk.offset < sizeof(COLUMN_MAGIC) ||
+        chunk.offset / sizeof(uint64_t) + payloadWords > file.footer.directoryOffset / sizeof(uint64_t)) {
+        return false;
+    }
+
+    const uint64_t* payload = file.words.data() + chunk.offset / sizeof(uint64_t);
+    std::vector<uint32_t> elements(count);
+    if (chunk.encoding == ENCODING_FLOAT32) {
+        memcpy(elements.data(), payload, count * sizeof(uint32_t));
+    }
+    else if (chunk.encoding == ENCODING_PACKED) {
+        for (size_t e = 0; e < count; e++) elements[e] = (uint32_t)(chunk.reference + packedField(payload, e, chunk.bits));
+    }
+    else {
+        const uint32_t* ranks = (const uint32_t*)(payload + bitmapWords);
+        const uint64_t* runValues = payload + bitmapWords + rankWords;
+        size_t run = 0;
+        for (size_t w = 0; w < bitmapWords; w++) {
+            if (ranks[w] != run) return false;
+            run += (size_t)__builtin_popcountll(payload[w]);
+        }
+        if (run != chunk.runs || (count > 0 && !(payload[0] & 1))) return false;
+        run = 0;
+        for (size_t e = 0; e < count; e++) {
+            if (payload[e / 64] >> (e % 64) & 1) run++;
+            elements[e] = (uint32_t)(chunk.reference + packedField(runValues, run - 1, chunk.bits));
+        }
+    }
+
+    values.resize(count);
+    for (uint32_t r = 0; r < chunk.rows; r++) {
+        for (uint32_t j = 0; j < file.footer.valuesPerRow; j++) values[(size_t)r * file.footer.valuesPerRow + j] = elements[(size_t)j * chunk.rows + r];
+    }
+    return true;
+}
+
+uint64_t hashShotRows(const ShotRows& rows) {
+    uint64_t hash = 14695981039346656037ull ^ rows.rows;
+    for (const std::vector<uint32_t>& column : rows.columns) {
+        for (uint32_t value : column) hash = (hash ^ value) * 1099511628211ull;
+    }
+    return hash;
+}
+
+int runVerifyExport(int argc, char** argv) {
+    ExportOptions options;
+    if (!parseExportOptions(argc, argv, options)) return 2;
+
+    ColumnFile files[EXPORT_COLUMN_COUNT];
+    for (int c = 0; c < EXPORT_COLUMN_COUNT; c++) {
+        if (!readColumnFile(options.prefix + "_" + EXPORT_COLUMNS[c].name + ".col", EXPORT_COLUMNS[c], files[c])) return 1;
+    }
+    const ColumnFooter& footer = files[0].footer;
+    for (int c = 1; c < EXPORT_COLUMN_COUNT; c++) {
+        bool aligned = files[c].footer.chunks == footer.chunks && files[c].footer.rows == footer.rows;
+        for (uint32_t k = 0; aligned && k < footer.chunks; k++) aligned = files[c].chunks[k].rows == files[0].chunks[k].rows;
+        if (!aligned) {
+            std::cerr << "Column " << EXPORT_COLUMNS[c].name << " does not have the same chunks as " << EXPORT_COLUMNS[0].name << std::endl;
+            return 1;
+        }
+    }
+
+    // Decode every chunk once to index it by the hash of its rows
+    std::function<bool(size_t, ShotRows&)> decodeChunk = [&](size_t k, ShotRows& rows) {
+        rows.rows = files[0].chunks[k].rows;
+        for (int c = 0; c < EXPORT_COLUMN_COUNT; c++) {
+            if (!decodeColumnChunk(files[c], k, rows.columns[c])) {
+                std::cerr << "Chunk " << k << " of column " << EXPORT_COLUMNS[c].name << " does not decode" << std::endl;
+                return false;
+            }
+        }
+        return true;
+    };
+    std::multimap<uint64_t, size_t> unmatched;
+    uint64_t fileRows = 0;
+    ShotRows decoded;
+    for (size_t k = 0; k < footer.chunks; k++) {
+        if (!decodeChunk(k, decoded)) return 1;
+        unmatched.insert({ hashShotRows(decoded), k });
+        fileRows += decoded.rows;
+    }
+    if (fileRows != footer.rows) {
+        std::cerr << "The chunks hold " << fileRows << " rows but the footers say " << footer.rows << std::endl;
+        return 1;
+    }
+
+    GameState table;
+    initializeGame(table);
+    tableField();
+    std::mutex mutex;
+    uint64_t matchedRows = 0, missingChunks = 0;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < options.threadCount; t++) {
+        workers.emplace_back([&, t] {
+            ShotRows stored;
+            playExportShots(options, table, t, [&](const ShotRows& rows) {
+                uint64_t hash = hashShotRows(rows);
+                std::lock_guard<std::mutex> lock(mutex);
+                std::pair<std::multimap<uint64_t, size_t>::iterator, std::multimap<uint64_t, size_t>::iterator> candidates = unmatched.equal_range(hash);
+                for (std::multimap<uint64_t, size_t>::iterator it = candidates.first; it != candidates.second; ++it) {
+                    bool same = decodeChunk(it->second, stored) && stored.rows == rows.rows;
+                    for (int c = 0; same && c < EXPORT_COLUMN_COUNT; c++) same = stored.columns[c] == rows.columns[c];
+                    if (same) {
+                        unmatched.erase(it);
+                        matchedRows += rows.rows;
+                        return;
+                    }
+                }
+                missingChunks++;
+            });
+        });
+    }
+    for (std::thread& worker : workers) worker.join();
+
+    std::cout << footer.rows << " rows in " << footer.chunks << " chunks read back from " << options.prefix << "_*.col: "
+              << matchedRows << " match the regenerated export, " << missingChunks << " regenerated chunks missing, "
+              << unmatched.size() << " chunks in the files not produced by it" << std::endl;
+    return missingChunks == 0 && unmatched.empty() ? 0 : 1;
+}
@@ -1,142 +1,202 @@
 #include <GL/glut.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
 #include <cmath>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <fstream>
+#include <functional>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <sstream>
+#include <string>
+#include <sys/mman.h>
+#include <thread>
+#include <type_traits>
+#include <unistd.h>
+#include <utility>
 #include <vector>
 
-// Constants
-const float PI = 3.14159f;
-const int NUM_BALLS = 16; // 15 colored balls + 1 cue ball
-
-// Ball structure
-struct Ball {
-    float x, y;           // Position
-    float vx, vy;         // Velocity
-    float radius;         // Radius
-    bool active;          // Is ball active (not pocketed)
-    int color[3];         // RGB color
-	int player;         // Player number (1 or 2)
+#include "history.h"
+#include "latency.h"
+#include "search.h"
+#include "shared_table.h"
+#include "tools.h"
+
+GameState game; // Owned by the simulation thread once it is started
+
+// A shot resolved ahead of time, for playback. Between events a ball only slows down by
+// friction along a straight line, so each ball stores a keyframe just where that stops being
+// true (a collision, a cushion, the per-axis minVelocity cut-off, being pocketed) and the
+// steps in between are rebuilt from the geometric series x + v * (1 - f^n) / (1 - f).
+struct Keyframe {
+    int step;       // State after this many steps
+    float x, y;
+    float vx, vy;   // Velocity for the next step
+    bool active;
 };
 
-// Pocket structure
-struct Pocket {
-    float x, y;           // Position
-    float radius;         // Radius
+struct Trajectory {
+    std::vector<std::vector<Keyframe>> balls; // Per ball, in step order; the first is the shot
+    int steps = 0;                            // Steps until everything stopped
+    float friction = 1.0f;
+
+    // Ball positions at a (fractional) step; balls beyond trajectory size are left alone
+    void sample(float step, Ball* out, int count) const {
+        step = std::max(0.0f, std::min(step, (float)steps));
+        for (int i = 0; i < count && i < (int)balls.size(); i++) {
+            const std::vector<Keyframe>& keys = balls[i];
+            // Last keyframe at or before the step
+            std::vector<Keyframe>::const_iterator next = std::upper_bound(keys.begin(), keys.end(), step,
+                [](float value, const Keyframe& key) { return value < (float)key.step; });
+            const Keyframe& key = next == keys.begin() ? keys.front() : *(next - 1);
+            float elapsed = std::max(0.0f, step - key.step);
+            float travel = friction < 1.0f ? (float)((1.0 - std::pow((double)friction, (double)elapsed)) / (1.0 - friction)) : elapsed;
+            out[i].x = key.x + key.vx * travel;
+            out[i].y = key.y + key.vy * travel;
+            out[i].vx = key.vx;
+            out[i].vy = key.vy;
+            out[i].active = key.active;
+        }
+    }
+
+    size_t keyframeCount() const {
+        size_t total = 0;
+        for (const std::vector<Keyframe>& keys : balls) total += keys.size();
+        return total;
+    }
 };
 
-// Game state
-struct GameState {
-    // Table properties
+// Immutable copy of everything display() needs, published once per simulation step
+struct FrameSnapshot {
+    Ball balls[NUM_BALLS];
+    int ballCount = 0;
+    Pocket pockets[NUM_POCKETS];
+    int pocketCount = 0;
     float tableWidth = 2.0f;
     float tableHeight = 1.0f;
     float cushionThickness = 0.05f;
-
-    // Balls
-    std::vector<Ball> balls;
-    int activeBalls = NUM_BALLS;
-
-    // Pockets
-    std::vector<Pocket> pockets;
-
-    // Cue properties
+    float curveRadius = 0.1f;
     float cueAngle = 0.0f;
-    float cueLength = 0.5f;
     float cuePower = 0.0f;
-    float maxCuePower = 0.05f;  // REDUCED maximum power (was 0.1f)
-    bool cueDragging = false;
-    bool cueAiming = true;
-
-    // Game state
+    float cueLength = 0.5f;
+    bool cueAiming = false;
     bool ballsMoving = false;
+    bool gameOver = false;
+    int currentPlayer = 1;
     int player1Score = 0;
     int player2Score = 0;
     int shots = 0;
-    bool gameOver = false;
-	int currentPlayer = 1; // Player 1 starts first
-    bool player1Solids = false;
-    bool player2Solids = false;
-	bool ballTypeAssigned = false; // Flag to check if ball type is assigned
-    bool potted = false;
-    bool foul = false;
     int winner = -1;
-    std::string message = "";
-
-    // Friction coefficient - INCREASED for more friction (was 0.992f)
-    float friction = 0.9992f;
-
-    // Minimum velocity threshold - INCREASED to stop balls sooner
-    float minVelocity = 0.00777f;
-
-} game;
-
-// Initialize ball positions in triangle formation
-void initializeBalls() {
-    game.balls.clear();
-
-    // Colors for balls (RGB values between 0-255, will be normalized)
-    int colors[NUM_BALLS][3] = {
-        {255, 255, 255},  // Cue ball (white)
-        {255, 255, 0},    // Yellow
-        {0, 0, 255},      // Blue
-        {255, 0, 0},      // Red
-        {128, 0, 128},    // Purple
-        {255, 165, 0},    // Orange
-        {155, 131, 131},      // Green
-        {128, 0, 0},      // Maroon
-        {0, 0, 0},        // Black (8-ball)
-        {255, 255, 0},    // Yellow striped
-        {0, 0, 255},      // Blue striped
-        {255, 0, 0},      // Red striped
-        {128, 0, 128},    // Purple striped
-        {255, 165, 0},    // Orange striped
-        {58, 128, 1},      // Green striped
-        {128, 0, 0}       // Maroon striped
-    };
+    bool computerThinking = false;
+    bool hintVisible = false;  // Suggested shot while aiming ('H')
+    float hintGhostX = 0.0f;   // Where the cue ball should meet the object ball
+    float hintGhostY = 0.0f;
+    float hintPower = 0.0f;
+
+    // Shot playback: display() places the balls from the trajectory at
+    // playbackStep + (now - playbackTime) / SIM_STEP * playbackSpeed
+    std::shared_ptr<const Trajectory> playback;
+    float playbackStep = 0.0f;
+    std::chrono::steady_clock::time_point playbackTime;
+    float playbackSpeed = 1.0f;
+};
 
-    float ballRadius = 0.03f;
-    float spacing = ballRadius * 2.1f; // Slight gap between balls
-
-    // Create cue ball
-    Ball cueBall;
-    cueBall.x = -0.4f;
-    cueBall.y = 0.0f;
-    cueBall.vx = 0.0f;
-    cueBall.vy = 0.0f;
-    cueBall.radius = ballRadius;
-    cueBall.active = true;
-    cueBall.color[0] = colors[0][0];
-    cueBall.color[1] = colors[0][1];
-    cueBall.color[2] = colors[0][2];
-    game.balls.push_back(cueBall);
-
-    // Create other balls in triangle formation
-    float startX = 0.4f;
-    float startY = 0.0f;
-
-    int ballIndex = 1;
-    for (int row = 0; row < 5; row++) {
-        for (int col = 0; col <= row; col++) {
-            if (ballIndex < NUM_BALLS) {
-                Ball ball;
-                ball.x = startX + row * spacing * 0.866f; // 0.866 = cos(30°)
-                ball.y = startY + (col - row / 2.0f) * spacing;
-                ball.vx = 0.0f;
-                ball.vy = 0.0f;
-                ball.radius = ballRadius;
-                ball.active = true;
-                ball.color[0] = colors[ballIndex][0];
-                ball.color[1] = colors[ballIndex][1];
-                ball.color[2] = colors[ballIndex][2];
-                // Assign player based on ball type (1-7 solids, 9-15 stripes, 8 neutral)
-                if (ballIndex >= 1 && ballIndex <= 7) ball.player = -1;  // Solids (player to be determined)
-                else if (ballIndex >= 9 && ballIndex <= 15) ball.player = -2;  // Stripes (player to be determined)
-                else ball.player = 0;  // 8-ball is neutral
-                game.balls.push_back(ball);
-                ballIndex++;
-            }
+// Lock-free triple buffer: one writer, one reader, neither ever waits.
+// The writer fills back() and publish()es it; the reader always gets the newest complete slot.
+template <typename T>
+class TripleBuffer {
+public:
+    T& back() { return slots[backIndex]; }
+
+    void publish() {
+        uint8_t previous = middle.exchange(backIndex | FRESH, std::memory_order_acq_rel);
+        backIndex = previous & INDEX_MASK;
+    }
+
+    const T& read() {
+        if (middle.load(std::memory_order_relaxed) & FRESH) {
+            uint8_t previous = middle.exchange(frontIndex, std::memory_order_acq_rel);
+            frontIndex = previous & INDEX_MASK;
         }
+        return slots[frontIndex];
+    }
+
+private:
+    static const uint8_t INDEX_MASK = 0x3;
+    static const uint8_t FRESH = 0x4;
+
+    T slots[3];
+    alignas(64) uint8_t backIndex = 0;          // Writer only
+    alignas(64) std::atomic<uint8_t> middle{1}; // Shared hand-off slot (+ FRESH bit)
+    alignas(64) uint8_t frontIndex = 2;         // Reader only
+};
+
+// Bounded single-producer/single-consumer ring buffer
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    bool push(const T& item) {
+        size_t tail = tailIndex.load(std::memory_order_relaxed);
+        if (tail - headIndex.load(std::memory_order_acquire) == Capacity) return false; // Full
+        items[tail & (Capacity - 1)] = item;
+        tailIndex.store(tail + 1, std::memory_order_release);
+        return true;
     }
-}
+
+    bool pop(T& item) {
+        size_t head = headIndex.load(std::memory_order_relaxed);
+        if (head == tailIndex.load(std::memory_order_acquire)) return false; // Empty
+        item = items[head & (Capacity - 1)];
+        headIndex.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    T items[Capacity];
+    alignas(64) std::atomic<size_t> headIndex{0}; // Consumer only writes
+    alignas(64) std::atomic<size_t> tailIndex{0}; // Producer only writes
+};
+
+// Input forwarded from the GLUT callbacks to the simulation thread
+enum class InputType { Aim, CuePress, CueRelease, Reset, ToggleComputer, SaveReplay, LoadReplay, ToggleHints, SkipPlayback, PlaybackSpeed, Undo, ToggleHistorySteps };
+
+struct InputEvent {
+    InputType type;
+    float x, y; // Aim target in OpenGL coordinates
+};
+
+TripleBuffer<FrameSnapshot> renderBuffer;
+SpscQueue<InputEvent, 256> inputQueue;
+std::atomic<bool> simulationRunning{false};
+std::thread simulationThread;
+
+// Frame pacing telemetry (render side is written by the GLUT thread, step side by the simulation thread)
+struct Telemetry {
+    LatencyHistogram displayTime;   // CPU time spent building a frame in display()
+    LatencyHistogram swapTime;      // Time blocked in glutSwapBuffers()
+    LatencyHistogram frameInterval; // Start-to-start time between display() calls
+    LatencyHistogram stepTime;      // update() plus snapshot publication
+    LatencyHistogram stepInterval;  // Start-to-start time between update() ticks
+    std::atomic<uint64_t> missedFrames{0};
+    std::atomic<uint64_t> missedSteps{0};
+    bool overlayVisible = false;    // GLUT thread only
+} telemetry;
+
+// A tick counts as missed when it starts more than half a period late
+const std::chrono::microseconds FRAME_PERIOD(16667);
+const std::chrono::microseconds MISSED_DEADLINE_SLACK(8333);
 
 void drawBackground() {
     // Save the current projection and modelview matrices
@@ -173,349 +233,9 @@ void drawBackground() {
     glMatrixMode(GL_MODELVIEW);
     glPopMatrix();
 }
-// Initialize pockets
-void initializePockets() {
-    game.pockets.clear();
-
-    float pocketRadius = 0.065f; // Radius of the pockets
-    float tableWidth = game.tableWidth;
-    float tableHeight = game.tableHeight;
-
-    // Add 6 pockets (4 corners, 2 middle sides)
-    Pocket pocket;
-
-    // Top-left corner pocket (moved outward)
-    pocket.x = -tableWidth / 2 ;
-    pocket.y = tableHeight / 2;
-    pocket.radius = pocketRadius;
-    game.pockets.push_back(pocket);
-
-    // Top-middle pocket (moved outward)
-    pocket.x = 0;
-    pocket.y = tableHeight / 2 + pocketRadius / 2;
-    pocket.radius = pocketRadius;
-    game.pockets.push_back(pocket);
-
-    // Top-right corner pocket (moved outward)
-    pocket.x = tableWidth / 2  ;
-    pocket.y = tableHeight / 2 ;
-    pocket.radius = pocketRadius;
-    game.pockets.push_back(pocket);
-
-    // Bottom-right corner pocket (moved outward)
-    pocket.x = tableWidth / 2 ;
-    pocket.y = -tableHeight / 2 ;
-    pocket.radius = pocketRadius;
-    game.pockets.push_back(pocket);
-
-    // Bottom-middle pocket (moved outward)
-    pocket.x = 0;
-    pocket.y = -tableHeight / 2 - pocketRadius / 2;
-    pocket.radius = pocketRadius;
-    game.pockets.push_back(pocket);
-
-    // Bottom-left corner pocket (moved outward)
-    pocket.x = -tableWidth / 2 ;
-    pocket.y = -tableHeight / 2 ;
-    pocket.radius = pocketRadius;
-    game.pockets.push_back(pocket);
-}
-
-// Initialize the game
-void initializeGame() {
-    initializeBalls();
-    initializePockets();
-    game.player1Score = 0;
-    game.player2Score = 0;
-    game.shots = 0;
-    game.gameOver = false;
-    game.ballsMoving = false;
-    game.cueAiming = true;
-    game.currentPlayer = 1;
-    game.player1Solids = false;
-    game.player2Solids = false;
-    game.ballTypeAssigned = false;
-    game.potted = false;
-    game.foul = false;
-    game.message = "Player 1's turn";
-}
-
-void switchPlayer() {
-    if (game.currentPlayer == 1) {
-        game.currentPlayer = 2;
-        game.message = "Player 2's turn";
-    }
-    else {
-        game.currentPlayer = 1;
-        game.message = "Player 1's turn";
-    }
-    game.potted = false;
-    game.foul = false;
-}
-void assignBallTypes(int pottedBallIndex) {
-    if (game.ballTypeAssigned) return;
-
-    // Determine if the potted ball is solid or striped
-    bool isSolid = (pottedBallIndex >= 1 && pottedBallIndex <= 7);
-
-    if (game.currentPlayer == 1) {
-        game.player1Solids = isSolid;
-        game.player2Solids = !isSolid;
-    }
-    else {
-        game.player2Solids = isSolid;
-        game.player1Solids = !isSolid;
-    }
-
-    // Assign balls to players
-    for (size_t i = 1; i < game.balls.size(); i++) {
-        if (i == 8) continue; // 8-ball is neutral
-
-        if (i >= 1 && i <= 7) { // Solids
-            game.balls[i].player = game.player1Solids ? 1 : 2;
-        }
-        else { // Stripes
-            game.balls[i].player = game.player1Solids ? 2 : 1;
-        }
-    }
-
-    game.ballTypeAssigned = true;
-
-    // Update message to inform players of their ball types
-    if (game.player1Solids) {
-        game.message = "Player 1: Solids, Player 2: Stripes";
-    }
-    else {
-        game.message = "Player 1: Stripes, Player 2: Solids";
-    }
-}
-
-bool checkWin(int player) {
-    // Check if all of the player's balls are pocketed
-    for (size_t i = 1; i < game.balls.size(); i++) {
-        if (i == 8) continue; // Skip 8-ball
-
-        if (game.balls[i].player == player && game.balls[i].active) {
-            return false; // Player still has active balls
-        }
-    }
-
-    // Check if 8-ball is pocketed (should be the last ball)
-    return !game.balls[8].active;
-}
-
-bool checkLoss(int player) {
-    // If the player pockets the 8-ball but still has their balls on the table
-    if (!game.balls[8].active) {
-        for (size_t i = 1; i < game.balls.size(); i++) {
-            if (i == 8) continue;
-
-            if (game.balls[i].player == player && game.balls[i].active) {
-                return true; // Player pocketed 8-ball too early
-            }
-        }
-    }
-
-    // If the player pockets the cue ball and the 8-ball in the same shot
-    if (!game.balls[0].active && !game.balls[8].active) {
-        return true;
-    }
-
-    return false;
-}
-// Check if a ball is pocketed
-void checkPockets() {
-    for (size_t i = 0; i < game.balls.size(); i++) {
-        if (!game.balls[i].active) continue;
-
-        for (size_t j = 0; j < game.pockets.size(); j++) {
-            float dx = game.balls[i].x - game.pockets[j].x;
-            float dy = game.balls[i].y - game.pockets[j].y;
-            float distance = sqrt(dx * dx + dy * dy);
-
-            if (distance < game.pockets[j].radius) {
-                // Ball is pocketed
-                game.balls[i].active = false;
-                game.activeBalls--;
-
-                // Special case for cue ball - respawn it
-                if (i == 0) {
-                    game.foul = true;
-                    // Respawn cue ball in a legal position
-                    game.balls[0].x = -0.4f;
-                    game.balls[0].y = 0.0f;
-                    game.balls[0].vx = 0.0f;
-                    game.balls[0].vy = 0.0f;
-                    game.balls[0].active = true;
-                    game.activeBalls++;
-                    game.message = "Foul! Scratched the cue ball";
-                }
-                // Special case for 8-ball (black ball)
-                else if (i == 8) {
-                    // Check if the player has potted all their assigned balls
-                    bool allAssignedBallsPotted = true;
-                    for (size_t k = 1; k < game.balls.size(); k++) {
-                        if (game.balls[k].player == game.currentPlayer && game.balls[k].active) {
-                            allAssignedBallsPotted = false;
-                            break;
-                        }
-                    }
-
-                    if (allAssignedBallsPotted) {
-                        // Player wins by potting the 8-ball after potting all their assigned balls
-                        game.gameOver = true;
-						game.winner = game.currentPlayer;
-                        game.message = "Player " + std::to_string(game.currentPlayer) + " wins by potting the black ball!";
-                    }
-                    else {
-                        // Player loses for potting the 8-ball too early
-                        game.gameOver = true;
-						game.winner = game.currentPlayer == 1 ? 2 : 1; // Opponent wins
-                        game.message = "Player " + std::to_string(game.currentPlayer) + " loses! Potted the black ball too early.";
-                    }
-                }
-                // Regular balls
-                else {
-                    // Assign ball types if not already assigned
-                    if (!game.ballTypeAssigned) {
-                        assignBallTypes(i);
-                    }
-
-                    // Check if the player potted their own ball
-                    if (game.balls[i].player == game.currentPlayer) {
-                        // Add to score
-                        if (game.currentPlayer == 1) {
-                            game.player1Score++;
-                        }
-                        else {
-                            game.player2Score++;
-                        }
-                        game.potted = true;
-                        game.message = "Good shot! Go again";
-                    }
-                    else {
-                        // Player potted opponent's ball
-                        if (game.currentPlayer == 1) {
-                            game.player2Score++;
-                        }
-                        else {
-                            game.player1Score++;
-                        }
-                        game.message = "Potted opponent's ball";
-                    }
-                }
-            }
-        }
-    }
-}
-
-// Handle ball-ball collisions
-void handleBallCollisions() {
-    for (size_t i = 0; i < game.balls.size(); i++) {
-        if (!game.balls[i].active) continue;
-
-        for (size_t j = i + 1; j < game.balls.size(); j++) {
-            if (!game.balls[j].active) continue;
-
-            // Calculate distance between balls
-            float dx = game.balls[j].x - game.balls[i].x;
-            float dy = game.balls[j].y - game.balls[i].y;
-            float distance = sqrt(dx * dx + dy * dy);
-
-            // Check for collision
-            if (distance < game.balls[i].radius + game.balls[j].radius) {
-                // Normalize the displacement vector
-                float nx = dx / distance;
-                float ny = dy / distance;
-
-                // Calculate relative velocity
-                float dvx = game.balls[j].vx - game.balls[i].vx;
-                float dvy = game.balls[j].vy - game.balls[i].vy;
-
-                // Calculate velocity along the normal
-                float velAlongNormal = dvx * nx + dvy * ny;
-
-                // Don't resolve if balls are moving away from each other
-                if (velAlongNormal > 0) continue;
-
-                // Collision response (elasticity coefficient = 0.8) - REDUCED elasticity (was 0.9f)
-                float elasticity = 0.1f;
-                float impulse = -(1 + elasticity) * velAlongNormal;
-
-                // Apply impulse to both balls
-                game.balls[i].vx -= nx * impulse;
-                game.balls[i].vy -= ny * impulse;
-                game.balls[j].vx += nx * impulse;
-                game.balls[j].vy += ny * impulse;
-
-                // Separate the balls to prevent sticking
-                float overlap = (game.balls[i].radius + game.balls[j].radius - distance) / 2.0f;
-                game.balls[i].x -= nx * overlap;
-                game.balls[i].y -= ny * overlap;
-                game.balls[j].x += nx * overlap;
-                game.balls[j].y += ny * overlap;
-            }
-        }
-    }
-}
-
-// Handle ball-cushion collisions
-void handleCushionCollisions() {
-    float tableLeft = -game.tableWidth / 2;
-    float tableRight = game.tableWidth / 2;
-    float tableTop = game.tableHeight / 2;
-    float tableBottom = -game.tableHeight / 2;
-
-    for (size_t i = 0; i < game.balls.size(); i++) {
-        if (!game.balls[i].active) continue;
-
-        // Left cushion
-        if (game.balls[i].x - game.balls[i].radius < tableLeft) {
-            game.balls[i].x = tableLeft + game.balls[i].radius;
-            game.balls[i].vx = -game.balls[i].vx * 0.8f; // REDUCED elasticity (was 0.9f)
-        }
-
-        // Right cushion
-        if (game.balls[i].x + game.balls[i].radius > tableRight) {
-            game.balls[i].x = tableRight - game.balls[i].radius;
-            game.balls[i].vx = -game.balls[i].vx * 0.8f; // REDUCED elasticity
-        }
-
-        // Bottom cushion
-        if (game.balls[i].y - game.balls[i].radius < tableBottom) {
-            game.balls[i].y = tableBottom + game.balls[i].radius;
-            game.balls[i].vy = -game.balls[i].vy * 0.8f; // REDUCED elasticity
-        }
-
-        // Top cushion
-        if (game.balls[i].y + game.balls[i].radius > tableTop) {
-            game.balls[i].y = tableTop - game.balls[i].radius;
-            game.balls[i].vy = -game.balls[i].vy * 0.8f; // REDUCED elasticity
-        }
-    }
-}
-
-// Check if all balls have stopped moving
-bool allBallsStopped() {
-    for (size_t i = 0; i < game.balls.size(); i++) {
-        if (!game.balls[i].active) continue;
-
-        if (fabs(game.balls[i].vx) > game.minVelocity || fabs(game.balls[i].vy) > game.minVelocity) {
-            return false;
-        }
-    }
-    return true;
-}
-
-// Handle mouse motion for aiming the cue
-void mouseMotion(int x, int y) {
+// Aim the cue at a point in OpenGL coordinates
+void aimCue(float glX, float glY) {
     if (!game.ballsMoving && game.cueAiming) {
-        // Convert mouse coordinates to OpenGL coordinates
-        float windowWidth = glutGet(GLUT_WINDOW_WIDTH);
-        float windowHeight = glutGet(GLUT_WINDOW_HEIGHT);
-        float glX = (2.0f * x / windowWidth) - 1.0f;
-        float glY = 1.0f - (2.0f * y / windowHeight);
-
         // Calculate angle between cue ball and mouse position
         float dx = glX - game.balls[0].x;
         float dy = glY - game.balls[0].y;
@@ -528,13 +248,51 @@ void mouseMotion(int x, int y) {
         }
     }
 }
-void drawTable() {
-    float tableLeft = -game.tableWidth / 2;
-    float tableRight = game.tableWidth / 2;
-    float tableTop = game.tableHeight / 2;
-    float tableBottom = -game.tableHeight / 2;
-    float cushionWidth = game.cushionThickness * 2.0f; // Increase cushion width
-    float curveRadius = 0.1f; // Radius of the curve near the pockets
+// Unit-circle vertex table for one tessellation level
+struct CircleTable {
+    int segments = 0;
+    std::vector<float> cosines;
+    std::vector<float> sines;
+};
+
+// Window pixels per world unit under the current glOrtho projection (set in reshape())
+float pixelsPerUnit = 540.0f;
+std::map<float, CircleTable> circleCache; // Keyed by world radius, cleared on resize
+
+// Fewest segments that keep the chord sagitta under a quarter pixel, as a multiple of 4
+// so quarter arcs start and end on exact vertices
+int segmentsForRadius(float radius) {
+    const float maxError = 0.25f;
+    float pixelRadius = radius * pixelsPerUnit;
+    int segments = 8;
+    if (pixelRadius > maxError) {
+        segments = (int)std::ceil(PI / std::acos(1.0f - maxError / pixelRadius));
+    }
+    segments = (segments + 3) / 4 * 4;
+    return std::max(8, std::min(segments, 360));
+}
+
+const CircleTable& circleFor(float radius) {
+    std::map<float, CircleTable>::iterator it = circleCache.find(radius);
+    if (it != circleCache.end()) return it->second;
+
+    CircleTable& table = circleCache[radius];
+    table.segments = segmentsForRadius(radius);
+    for (int j = 0; j <= table.segments; j++) {
+        float angle = j * 2.0f * PI / table.segments;
+        table.cosines.push_back(cos(angle));
+        table.sines.push_back(sin(angle));
+    }
+    return table;
+}
+
+void drawTable(const FrameSnapshot& s) {
+    float tableLeft = -s.tableWidth / 2;
+    float tableRight = s.tableWidth / 2;
+    float tableTop = s.tableHeight / 2;
+    float tableBottom = -s.tableHeight / 2;
+    float cushionWidth = s.cushionThickness * 2.0f; // Increase cushion width
+    float curveRadius = s.curveRadius; // Radius of the curve near the pockets
 
     // Draw table border (dark brown)
     glColor3f(0.4f, 0.2f, 0.1f);
@@ -591,43 +349,41 @@ void drawTable() {
     glEnd();
 
     // Add curved sections near the corner pockets
+    const CircleTable& curve = circleFor(curveRadius);
+    int quarter = curve.segments / 4;
     glColor3f(0.2f, 0.5f, 0.2f); // Same color as cushions
     glBegin(GL_POLYGON);
     // Top-left corner curve
-    for (int i = 0; i <= 90; i++) {
-        float angle = i * PI / 180.0f;
-        float x = tableLeft + curveRadius * cos(angle);
-        float y = tableTop - curveRadius * sin(angle);
+    for (int i = 0; i <= quarter; i++) {
+        float x = tableLeft + curveRadius * curve.cosines[i];
+        float y = tableTop - curveRadius * curve.sines[i];
         glVertex2f(x, y);
     }
     glEnd();
 
     glBegin(GL_POLYGON);
     // Top-right corner curve
-    for (int i = 0; i <= 90; i++) {
-        float angle = i * PI / 180.0f;
-        float x = tableRight - curveRadius * cos(angle);
-        float y = tableTop - curveRadius * sin(angle);
+    for (int i = 0; i <= quarter; i++) {
+        float x = tableRight - curveRadius * curve.cosines[i];
+        float y = tableTop - curveRadius * curve.sines[i];
         glVertex2f(x, y);
     }
     glEnd();
 
     glBegin(GL_POLYGON);
     // Bottom-left corner curve
-    for (int i = 0; i <= 90; i++) {
-        float angle = i * PI / 180.0f;
-        float x = tableLeft + curveRadius * cos(angle);
-        float y = tableBottom + curveRadius * sin(angle);
+    for (int i = 0; i <= quarter; i++) {
+        float x = tableLeft + curveRadius * curve.cosines[i];
+        float y = tableBottom + curveRadius * curve.sines[i];
         glVertex2f(x, y);
     }
     glEnd();
 
     glBegin(GL_POLYGON);
     // Bottom-right corner curve
-    for (int i = 0; i <= 90; i++) {
-        float angle = i * PI / 180.0f;
-        float x = tableRight - curveRadius * cos(angle);
-        float y = tableBottom + curveRadius * sin(angle);
+    for (int i = 0; i <= quarter; i++) {
+        float x = tableRight - curveRadius * curve.cosines[i];
+        float y = tableBottom + curveRadius * curve.sines[i];
         glVertex2f(x, y);
     }
     glEnd();
@@ -635,13 +391,13 @@ void drawTable() {
 
 void drawBall(const Ball& ball) {
     if (!ball.active) return;
+    const CircleTable& circle = circleFor(ball.radius);
 
     // Draw ball (shaded)
     glBegin(GL_POLYGON);
-    for (int j = 0; j < 36; j++) {
-        float angle = j * 10 * PI / 180.0f;
-        float x = ball.x + ball.radius * cos(angle);
-        float y = ball.y + ball.radius * sin(angle);
+    for (int j = 0; j < circle.segments; j++) {
+        float x = ball.x + ball.radius * circle.cosines[j];
+        float y = ball.y + ball.radius * circle.sines[j];
         glColor3f(ball.color[0] / 255.0f * 0.8f, ball.color[1] / 255.0f * 0.8f, ball.color[2] / 255.0f * 0.8f); // Shaded color
         glVertex2f(x, y);
     }
@@ -650,37 +406,67 @@ void drawBall(const Ball& ball) {
     // Draw ball outline
     glColor3f(0.0f, 0.0f, 0.0f); // Black outline
     glBegin(GL_LINE_LOOP);
-    for (int j = 0; j < 36; j++) {
-        float angle = j * 10 * PI / 180.0f;
-        float x = ball.x + ball.radius * cos(angle);
-        float y = ball.y + ball.radius * sin(angle);
+    for (int j = 0; j < circle.segments; j++) {
+        float x = ball.x + ball.radius * circle.cosines[j];
+        float y = ball.y + ball.radius * circle.sines[j];
         glVertex2f(x, y);
     }
     glEnd();
 }
 
-// Handle mouse clicks for shooting the cue
-void mouseClick(int button, int state, int x, int y) {
-    if (game.gameOver || game.ballsMoving) return;
+// Start or release a cue drag (simulation thread)
+void pressCue() {
+    if (game.gameOver || game.ballsMoving || !game.cueAiming) return;
+    game.cueDragging = true;
+}
 
-    if (button == GLUT_LEFT_BUTTON) {
-        if (state == GLUT_DOWN) {
-            game.cueDragging = true;
-        }
-        else if (state == GLUT_UP && game.cueDragging) {
-            // Shoot the cue ball
-            float shotAngle = game.cueAngle + PI; // Reverse the angle
+void releaseCue() {
+    if (game.gameOver || game.ballsMoving || !game.cueDragging) return;
+    applyShot(game, game.cueAngle, game.cuePower);
+}
 
-            // REDUCED the velocity factor by 50% to make shots slower
-            float velocityFactor = 0.5f;
-            game.balls[0].vx = cos(shotAngle) * game.cuePower * velocityFactor;
-            game.balls[0].vy = sin(shotAngle) * game.cuePower * velocityFactor;
+// Input the queue had no room for (GLUT thread only), retried in order ahead of anything newer
+std::deque<InputEvent> inputBacklog;
 
-            game.ballsMoving = true;
-            game.cueAiming = false;
-            game.cueDragging = false;
-            game.shots++;
-        }
+void flushInput() {
+    while (!inputBacklog.empty() && inputQueue.push(inputBacklog.front())) {
+        inputBacklog.pop_front();
+    }
+}
+
+// Forward input to the simulation thread without ever dropping a press, release or key
+void sendInput(const InputEvent& event) {
+    flushInput();
+    if (inputBacklog.empty() && inputQueue.push(event)) return;
+
+    // Only the newest aim matters, so a waiting one is replaced rather than queued behind
+    if (event.type == InputType::Aim && !inputBacklog.empty() && inputBacklog.back().type == InputType::Aim) {
+        inputBacklog.back() = event;
+    }
+    else {
+        inputBacklog.push_back(event);
+    }
+}
+
+// Handle mouse motion for aiming the cue
+void mouseMotion(int x, int y) {
+    // Convert mouse coordinates to OpenGL coordinates
+    float windowWidth = glutGet(GLUT_WINDOW_WIDTH);
+    float windowHeight = glutGet(GLUT_WINDOW_HEIGHT);
+    float glX = (2.0f * x / windowWidth) - 1.0f;
+    float glY = 1.0f - (2.0f * y / windowHeight);
+    sendInput({ InputType::Aim, glX, glY });
+}
+
+// Handle mouse clicks for shooting the cue
+void mouseClick(int button, int state, int x, int y) {
+    if (button != GLUT_LEFT_BUTTON) return;
+
+    if (state == GLUT_DOWN) {
+        sendInput({ InputType::CuePress, 0.0f, 0.0f });
+    }
+    else if (state == GLUT_UP) {
+        sendInput({ InputType::CueRelease, 0.0f, 0.0f });
     }
 }
 
@@ -736,16 +522,16 @@ void drawGameOverScreen() {
         glutBitmapCharacter(GLUT_BITMAP_HELVETICA_18, c);
     }
 }
-void drawPockets() {
-    for (size_t i = 0; i < game.pockets.size(); i++) {
-        const Pocket& pocket = game.pockets[i];
+void drawPockets(const FrameSnapshot& s) {
+    for (size_t i = 0; i < (size_t)s.pocketCount; i++) {
+        const Pocket& pocket = s.pockets[i];
+        const CircleTable& circle = circleFor(pocket.radius);
         //Corner Pockets
         if (i == 0 || i == 2 || i == 3 || i == 5) {
             glBegin(GL_POLYGON);
-            for (int j = 0; j < 360; j++) { // Draw a full circle (360 degrees)
-                float angle = j * PI / 180.0f;
-                float x = pocket.x + pocket.radius * cos(angle);
-                float y = pocket.y + pocket.radius * sin(angle);
+            for (int j = 0; j < circle.segments; j++) { // Draw a full circle
+                float x = pocket.x + pocket.radius * circle.cosines[j];
+                float y = pocket.y + pocket.radius * circle.sines[j];
                 glVertex2f(x, y);
             }
             glEnd();
@@ -753,31 +539,55 @@ void drawPockets() {
         // Center pockets (semi-circles)
         else {
             glBegin(GL_POLYGON);
-            for (int j = 0; j <= 360; j++) { // Draw a semi-circle (180 degrees)
-                float angle = j * PI / 180.0f;
-
+            for (int j = 0; j <= circle.segments; j++) { // Draw a semi-circle (180 degrees)
                 // Adjust the semi-circle to face the table
                 float yOffset = (i == 1) ? 1 : -1; // Top or bottom
-                float x = pocket.x + pocket.radius * cos(angle);
-                float y = pocket.y + yOffset * pocket.radius * sin(angle);
+                float x = pocket.x + pocket.radius * circle.cosines[j];
+                float y = pocket.y + yOffset * pocket.radius * circle.sines[j];
                 glVertex2f(x, y);
             }
             glEnd();
         }
     }
 }
-void drawCueStick() {
-    if (!game.ballsMoving && game.cueAiming && game.balls[0].active && !game.gameOver) {
+// Aim hint: a line from the cue ball to the ghost ball and its outline
+void drawAimHint(const FrameSnapshot& s) {
+    if (!s.hintVisible || s.ballsMoving || !s.cueAiming || !s.balls[0].active) return;
+
+    float radius = s.balls[0].radius;
+    glColor3f(1.0f, 1.0f, 1.0f);
+    glBegin(GL_LINES);
+    glVertex2f(s.balls[0].x, s.balls[0].y);
+    glVertex2f(s.hintGhostX, s.hintGhostY);
+    glEnd();
+
+    const CircleTable& circle = circleFor(radius);
+    glBegin(GL_LINE_LOOP);
+    for (int j = 0; j < circle.segments; j++) {
+        glVertex2f(s.hintGhostX + radius * circle.cosines[j], s.hintGhostY + radius * circle.sines[j]);
+    }
+    glEnd();
+
+    std::stringstream power;
+    power << "Power " << (int)(s.hintPower * 100.0f) << "%";
+    glRasterPos2f(s.hintGhostX + radius * 1.5f, s.hintGhostY + radius * 1.5f);
+    for (char c : power.str()) {
+        glutBitmapCharacter(GLUT_BITMAP_HELVETICA_12, c);
+    }
+}
+
+void drawCueStick(const FrameSnapshot& s) {
+    if (!s.ballsMoving && s.cueAiming && s.balls[0].active && !s.gameOver) {
         // Calculate the starting position of the cue stick at the edge of the ball (opposite side)
-        float cueStartX = game.balls[0].x - cos(game.cueAngle + PI) * game.balls[0].radius;
-        float cueStartY = game.balls[0].y - sin(game.cueAngle + PI) * game.balls[0].radius;
+        float cueStartX = s.balls[0].x - cos(s.cueAngle + PI) * s.balls[0].radius;
+        float cueStartY = s.balls[0].y - sin(s.cueAngle + PI) * s.balls[0].radius;
 
         // Calculate the ending position of the cue stick based on the aiming angle and power (opposite direction)
-        float cueEndX = game.balls[0].x + cos(game.cueAngle) * (game.cueLength + game.cuePower * 3.0f);
-        float cueEndY = game.balls[0].y + sin(game.cueAngle) * (game.cueLength + game.cuePower * 3.0f);
+        float cueEndX = s.balls[0].x + cos(s.cueAngle) * (s.cueLength + s.cuePower * 3.0f);
+        float cueEndY = s.balls[0].y + sin(s.cueAngle) * (s.cueLength + s.cuePower * 3.0f);
 
         // Draw the cue stick
-        if (game.currentPlayer == 1) { glColor3f(0.9f, 0.4f, 0.02f); }
+        if (s.currentPlayer == 1) { glColor3f(0.9f, 0.4f, 0.02f); }
         else { glColor3f(0.5f, 1.0f, 1.0f); }// Cue stick color
         glLineWidth(8.0f);
         glBegin(GL_LINES);
@@ -788,39 +598,103 @@ void drawCueStick() {
 
         // Draw the cue end
         glColor3f(0.8f, 0.8f, 0.8f); // Light gray end
+        const CircleTable& circle = circleFor(s.balls[0].radius * 0.3f);
         glBegin(GL_POLYGON);
-        for (int j = 0; j < 36; j++) {
-            float angle = j * 10 * PI / 180.0f;
-            float x = cueEndX + game.balls[0].radius * 0.3f * cos(angle);
-            float y = cueEndY + game.balls[0].radius * 0.3f * sin(angle);
+        for (int j = 0; j < circle.segments; j++) {
+            float x = cueEndX + s.balls[0].radius * 0.3f * circle.cosines[j];
+            float y = cueEndY + s.balls[0].radius * 0.3f * circle.sines[j];
             glVertex2f(x, y);
         }
         glEnd();
     }
 }
+// One "name p50/p95/p99/max" line for the telemetry overlay and dump
+std::string formatHistogram(const char* name, const LatencyHistogram& histogram) {
+    std::stringstream line;
+    line << name << ": p50 " << histogram.percentile(50) << "us  p95 " << histogram.percentile(95)
+         << "us  p99 " << histogram.percentile(99) << "us  max " << histogram.max() << "us  (n=" << histogram.count() << ")";
+    return line.str();
+}
+
+std::vector<std::string> telemetryReport() {
+    std::vector<std::string> lines;
+    lines.push_back(formatHistogram("Frame interval", telemetry.frameInterval));
+    lines.push_back(formatHistogram("display()", telemetry.displayTime));
+    lines.push_back(formatHistogram("glutSwapBuffers()", telemetry.swapTime));
+    lines.push_back(formatHistogram("Step interval", telemetry.stepInterval));
+    lines.push_back(formatHistogram("update()", telemetry.stepTime));
+    std::stringstream missed;
+    missed << "Missed deadlines: frames " << telemetry.missedFrames.load(std::memory_order_relaxed)
+           << " | steps " << telemetry.missedSteps.load(std::memory_order_relaxed);
+    lines.push_back(missed.str());
+    return lines;
+}
+
+void drawTelemetryOverlay() {
+    std::vector<std::string> lines = telemetryReport();
+    glColor3f(1.0f, 1.0f, 0.0f);
+    for (size_t i = 0; i < lines.size(); i++) {
+        glRasterPos2f(0.15f, 0.92f - i * 0.05f);
+        for (char c : lines[i]) {
+            glutBitmapCharacter(GLUT_BITMAP_HELVETICA_12, c);
+        }
+    }
+}
+
+// Append the current percentiles to a dump file
+void dumpTelemetry(const char* path) {
+    std::ofstream out(path, std::ios::app);
+    if (!out) {
+        std::cerr << "Could not open " << path << " for telemetry dump" << std::endl;
+        return;
+    }
+    for (const std::string& line : telemetryReport()) {
+        out << line << "\n";
+    }
+    out << "\n";
+}
+
 // Display function
 void display() {
+    static std::chrono::steady_clock::time_point lastFrameStart;
+    std::chrono::steady_clock::time_point frameStart = std::chrono::steady_clock::now();
+    if (lastFrameStart.time_since_epoch().count() != 0) {
+        telemetry.frameInterval.record(elapsedMicros(lastFrameStart, frameStart));
+        if (frameStart - lastFrameStart > FRAME_PERIOD + MISSED_DEADLINE_SLACK) {
+            telemetry.missedFrames.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    lastFrameStart = frameStart;
+
+    const FrameSnapshot& s = renderBuffer.read();
+
     glClear(GL_COLOR_BUFFER_BIT);
     drawBackground();
     glLoadIdentity();
 
-	drawTable();
+	drawTable(s);
 
     // Draw pockets
     glColor3f(0.0f, 0.0f, 0.0f); // Black color for pockets
-    drawPockets();
-
-    // Draw balls
-    for (size_t i = 0; i < game.balls.size(); i++) {
-        if (!game.balls[i].active) continue;
+    drawPockets(s);
+
+    // Draw balls, from the shot trajectory while one is playing back
+    Ball balls[NUM_BALLS];
+    std::copy(s.balls, s.balls + s.ballCount, balls);
+    if (s.playback) {
+        float elapsedSteps = std::chrono::duration<float>(frameStart - s.playbackTime) / SIM_STEP;
+        s.playback->sample(s.playbackStep + elapsedSteps * s.playbackSpeed, balls, s.ballCount);
+    }
+    for (size_t i = 0; i < (size_t)s.ballCount; i++) {
+        if (!balls[i].active) continue;
 
         // Draw ball
-        glColor3f(game.balls[i].color[0] / 255.0f, game.balls[i].color[1] / 255.0f, game.balls[i].color[2] / 255.0f);
+        const CircleTable& circle = circleFor(balls[i].radius);
+        glColor3f(balls[i].color[0] / 255.0f, balls[i].color[1] / 255.0f, balls[i].color[2] / 255.0f);
         glBegin(GL_POLYGON);
-        for (int j = 0; j < 36; j++) {
-            float angle = j * 10 * PI / 180.0f;
-            float x = game.balls[i].x + game.balls[i].radius * cos(angle);
-            float y = game.balls[i].y + game.balls[i].radius * sin(angle);
+        for (int j = 0; j < circle.segments; j++) {
+            float x = balls[i].x + balls[i].radius * circle.cosines[j];
+            float y = balls[i].y + balls[i].radius * circle.sines[j];
             glVertex2f(x, y);
         }
         glEnd();
@@ -829,17 +703,16 @@ void display() {
         if (i >= 9) {
             glColor3f(1.0f, 1.0f, 1.0f);
             glBegin(GL_POLYGON);
-            for (int j = 0; j < 36; j++) {
-                float angle = j * 10 * PI / 180.0f;
+            for (int j = 0; j < circle.segments; j++) {
                 // Make stripes only cover top half
-                if (sin(angle) > 0) {
-                    float x = game.balls[i].x + game.balls[i].radius * cos(angle);
-                    float y = game.balls[i].y + game.balls[i].radius * sin(angle);
+                if (circle.sines[j] > 0) {
+                    float x = balls[i].x + balls[i].radius * circle.cosines[j];
+                    float y = balls[i].y + balls[i].radius * circle.sines[j];
                     glVertex2f(x, y);
                 }
                 else {
-                    float x = game.balls[i].x + game.balls[i].radius * 0.5f * cos(angle);
-                    float y = game.balls[i].y + game.balls[i].radius * 0.5f * sin(angle);
+                    float x = balls[i].x + balls[i].radius * 0.5f * circle.cosines[j];
+                    float y = balls[i].y + balls[i].radius * 0.5f * circle.sines[j];
                     glVertex2f(x, y);
                 }
             }
@@ -848,26 +721,27 @@ void display() {
 
         // Draw number on ball 8 (black ball)
         if (i == 8) {
+            const CircleTable& numberCircle = circleFor(balls[i].radius * 0.3f);
             glColor3f(1.0f, 1.0f, 1.0f);
             glBegin(GL_POLYGON);
-            for (int j = 0; j < 36; j++) {
-                float angle = j * 10 * PI / 180.0f;
-                float x = game.balls[i].x + game.balls[i].radius * 0.3f * cos(angle);
-                float y = game.balls[i].y + game.balls[i].radius * 0.3f * sin(angle);
+            for (int j = 0; j < numberCircle.segments; j++) {
+                float x = balls[i].x + balls[i].radius * 0.3f * numberCircle.cosines[j];
+                float y = balls[i].y + balls[i].radius * 0.3f * numberCircle.sines[j];
                 glVertex2f(x, y);
             }
             glEnd();
         }
     }
 
-    // Draw cue stick
-    drawCueStick();
+    // Draw aim hint and cue stick
+    drawAimHint(s);
+    drawCueStick(s);
     // Display score and shots
     glColor3f(1.0f, 1.0f, 1.0f);
     glRasterPos2f(-0.95f, 0.92f);
 
     std::stringstream scoreStream;
-    scoreStream << "Player 1: " << game.player1Score << " | Player 2: " << game.player2Score << " | Shots: " << game.shots;
+    scoreStream << "Player 1: " << s.player1Score << " | Player 2: " << s.player2Score << " | Shots: " << s.shots;
     std::string scoreText = scoreStream.str();
 
     for (char c : scoreText) {
@@ -875,14 +749,14 @@ void display() {
     }
 
     glRasterPos2f(-0.95f, 0.85f);
-	if (game.currentPlayer == 1) {
+	if (s.currentPlayer == 1) {
 		std::string playerText = "Player 1's Turn";
 		for (char c : playerText) {
 			glutBitmapCharacter(GLUT_BITMAP_HELVETICA_18, c);
 		}
 	}
 	else {
-		std::string playerText = "Player 2's Turn";
+		std::string playerText = s.computerThinking ? "Player 2's Turn (computer is thinking...)" : "Player 2's Turn";
 		for (char c : playerText) {
 			glutBitmapCharacter(GLUT_BITMAP_HELVETICA_18, c);
 		}
@@ -892,13 +766,13 @@ void display() {
 
     // Display controls
     glRasterPos2f(-0.95f, -0.92f);
-    std::string controlsText = "Controls: Click and drag to aim and shoot";
+    std::string controlsText = "Controls: Click and drag to aim and shoot | Space: skip shot | +/-: shot speed | U: undo | H: aim hint | C: computer plays Player 2 | W/L: save/load replay";
     for (char c : controlsText) {
         glutBitmapCharacter(GLUT_BITMAP_HELVETICA_12, c);
     }
 
     // Display game over message
-    if (game.gameOver) {
+    if (s.gameOver) {
         glColor3f(1.0f, 0.0f, 0.0f);
         glRasterPos2f(-0.25f, 0.0f);
         std::string gameOverText = "GAME OVER";
@@ -908,9 +782,9 @@ void display() {
 
         glRasterPos2f(-0.3f, -0.1f);
         std::stringstream finalScoreStream;
-		finalScoreStream << "Final Score: Player 1: " << game.player1Score << " | Player 2: " << game.player2Score;
+		finalScoreStream << "Final Score: Player 1: " << s.player1Score << " | Player 2: " << s.player2Score;
 		
-			finalScoreStream << game.winner<<" Wins!";
+			finalScoreStream << s.winner<<" Wins!";
         std::string finalScoreText = finalScoreStream.str();
         for (char c : finalScoreText) {
             glutBitmapCharacter(GLUT_BITMAP_HELVETICA_18, c);
@@ -923,52 +797,568 @@ void display() {
         }
     }
 
+    if (telemetry.overlayVisible) {
+        drawTelemetryOverlay();
+    }
+
+    std::chrono::steady_clock::time_point swapStart = std::chrono::steady_clock::now();
+    telemetry.displayTime.record(elapsedMicros(frameStart, swapStart));
     glutSwapBuffers();
+    telemetry.swapTime.record(elapsedMicros(swapStart, std::chrono::steady_clock::now()));
 }
 
-// Update function for game logic
-void update(int value) {
-    if (!game.gameOver) {
-        if (game.ballsMoving) {
-            // Update ball positions based on velocity
-            for (size_t i = 0; i < game.balls.size(); i++) {
-                if (!game.balls[i].active) continue;
+// simulateToRest() that also records the shot for playback. A ball gets a keyframe whenever the
+// step left it anywhere other than where plain friction would have (the minVelocity cut-off
+// included, since Trajectory::sample() cannot reproduce it). With a history, every step also
+// becomes a history entry.
+Trajectory recordShot(GameState& g, int maxSteps, GameHistory* history = nullptr) {
+    Trajectory trajectory;
+    trajectory.friction = g.physics.friction;
+    trajectory.balls.resize(g.balls.size());
+    for (size_t i = 0; i < g.balls.size(); i++) {
+        const Ball& ball = g.balls[i];
+        trajectory.balls[i].push_back({ 0, ball.x, ball.y, ball.vx, ball.vy, ball.active });
+    }
 
-                game.balls[i].x += game.balls[i].vx;
-                game.balls[i].y += game.balls[i].vy;
+    std::vector<Ball> expected;
+    while (g.ballsMoving && !g.gameOver && trajectory.steps < maxSteps) {
+        expected = g.balls;
+        for (Ball& ball : expected) {
+            if (!ball.active) continue;
+            ball.x += ball.vx;
+            ball.y += ball.vy;
+            ball.vx *= g.physics.friction;
+            ball.vy *= g.physics.friction;
+        }
+        update(g);
+        trajectory.steps++;
+        if (history) history->record(g, false);
+
+        for (size_t i = 0; i < g.balls.size(); i++) {
+            const Ball& ball = g.balls[i];
+            const Ball& free = expected[i];
+            if (ball.x != free.x || ball.y != free.y || ball.vx != free.vx || ball.vy != free.vy || ball.active != free.active) {
+                trajectory.balls[i].push_back({ trajectory.steps, ball.x, ball.y, ball.vx, ball.vy, ball.active });
+            }
+        }
+    }
+    return trajectory;
+}
 
-                // Apply friction - higher value = more friction = faster slowdown
-                game.balls[i].vx *= game.friction;
-                game.balls[i].vy *= game.friction;
+// Background worker pool for slow work the turn flow awaits (AI search, replay file IO)
+class BackgroundPool {
+public:
+    explicit BackgroundPool(int threadCount) {
+        for (int i = 0; i < threadCount; i++) {
+            workers.emplace_back([this] {
+                for (;;) {
+                    std::function<void()> job;
+                    {
+                        std::unique_lock<std::mutex> lock(mutex);
+                        jobAvailable.wait(lock, [this] { return stopping || !jobs.empty(); });
+                        if (stopping) return;
+                        job = std::move(jobs.front());
+                        jobs.pop_front();
+                    }
+                    job();
+                }
+            });
+        }
+    }
 
-                // Stop ball if velocity is very low
-                if (fabs(game.balls[i].vx) < game.minVelocity) game.balls[i].vx = 0.0f;
-                if (fabs(game.balls[i].vy) < game.minVelocity) game.balls[i].vy = 0.0f;
-            }
-            
-            // Handle collisions
-            handleBallCollisions();
-            handleCushionCollisions();
-
-            // Check for pocketed balls
-            checkPockets();
-
-            // Check if all balls have stopped
-            if (allBallsStopped()) {
-                game.ballsMoving = false;
-                game.cueAiming = true;
-                game.cuePower = 0.0f;
-                if (!game.potted || game.foul) {
-                    switchPlayer();
+    ~BackgroundPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        jobAvailable.notify_all();
+        for (std::thread& worker : workers) worker.join();
+    }
+
+    void post(std::function<void()> job) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.push_back(std::move(job));
+        }
+        jobAvailable.notify_one();
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable jobAvailable;
+    std::deque<std::function<void()>> jobs;
+    bool stopping = false;
+    std::vector<std::thread> workers;
+};
+
+BackgroundPool& backgroundPool() {
+    static BackgroundPool pool(2);
+    return pool;
+}
+
+// Coroutine resumed by the simulation loop once per tick. While it awaits background
+// work it stays parked until that work is done, so a tick never blocks on it.
+class TurnTask {
+public:
+    struct promise_type {
+        std::shared_ptr<const std::atomic<bool>> blocker; // Null = resume on the next tick
+
+        TurnTask get_return_object() { return TurnTask(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    TurnTask() = default;
+    explicit TurnTask(std::coroutine_handle<promise_type> h) : handle(h) {}
+    TurnTask(TurnTask&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+    TurnTask& operator=(TurnTask&& other) noexcept {
+        if (this != &other) {
+            if (handle) handle.destroy();
+            handle = std::exchange(other.handle, nullptr);
+        }
+        return *this;
+    }
+    ~TurnTask() {
+        if (handle) handle.destroy();
+    }
+
+    void tick() {
+        if (!handle || handle.done()) return;
+        promise_type& promise = handle.promise();
+        if (promise.blocker && !promise.blocker->load(std::memory_order_acquire)) return;
+        promise.blocker.reset();
+        handle.resume();
+    }
+
+private:
+    std::coroutine_handle<promise_type> handle;
+};
+
+// co_await nextTick() - yield until the next simulation step
+struct NextTick {
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<TurnTask::promise_type>) const noexcept {}
+    void await_resume() const noexcept {}
+};
+
+NextTick nextTick() {
+    return NextTick();
+}
+
+// co_await runInBackground(f) - run f on the background pool, resume with its result.
+// The job owns its state, so a turn flow destroyed mid-wait (reset) is harmless.
+template <typename T>
+struct BackgroundJob {
+    std::atomic<bool> done{false};
+    T value;
+};
+
+template <typename T>
+struct BackgroundResult {
+    std::shared_ptr<BackgroundJob<T>> job;
+
+    bool await_ready() const noexcept { return job->done.load(std::memory_order_acquire); }
+    void await_suspend(std::coroutine_handle<TurnTask::promise_type> h) const {
+        h.promise().blocker = std::shared_ptr<const std::atomic<bool>>(job, &job->done);
+    }
+    T await_resume() { return std::move(job->value); }
+};
+
+template <typename F>
+BackgroundResult<std::invoke_result_t<F>> runInBackground(F work) {
+    typedef std::invoke_result_t<F> Result;
+    std::shared_ptr<BackgroundJob<Result>> job = std::make_shared<BackgroundJob<Result>>();
+    backgroundPool().post([job, work]() mutable {
+        job->value = work();
+        job->done.store(true, std::memory_order_release);
+    });
+    return BackgroundResult<Result>{ job };
+}
+
+struct Replay {
+    bool loaded = false;
+    std::vector<ShotRecord> shots;
+};
+
+Replay loadReplay(const std::string& path) {
+    Replay replay;
+    std::ifstream in(path);
+    ShotRecord shot;
+    while (in >> shot.cueAngle >> shot.cuePower) {
+        replay.shots.push_back(shot);
+    }
+    replay.loaded = in.eof() && !replay.shots.empty();
+    return replay;
+}
+
+bool saveReplay(const std::string& path, const std::vector<ShotRecord>& shots) {
+    std::ofstream out(path);
+    out.precision(9); // Enough digits to round-trip a float exactly
+    for (const ShotRecord& shot : shots) {
+        out << shot.cueAngle << " " << shot.cuePower << "\n";
+    }
+    return (bool)out;
+}
+
+// Turn flow state shared with the input handlers (simulation thread only)
+bool player2Computer = false;
+bool computerThinking = false;
+bool aimHints = false;
+bool aimHintFound = false;
+AimCandidate aimHint;
+std::vector<ShotRecord> shotLog; // Shots since the last reset, for saving a replay
+
+// Undo history: every turn start, plus every shot step while historySteps is on ('V')
+GameHistory history(4 << 20, 1 << 16);
+bool historySteps = false;
+uint64_t turnEntry = 0; // History entry of the turn being played
+
+// Playback of the shot in progress; see FrameSnapshot::playback
+std::shared_ptr<const Trajectory> playback;
+float playbackStep = 0.0f;
+std::chrono::steady_clock::time_point playbackTime;
+float playbackSpeed = 1.0f;
+
+float playbackPosition(std::chrono::steady_clock::time_point now) {
+    return playbackStep + std::chrono::duration<float>(now - playbackTime) / SIM_STEP * playbackSpeed;
+}
+
+// Keep the animation where it is and carry on at a new rate
+void setPlaybackSpeed(float speed) {
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    playbackStep = playbackPosition(now);
+    playbackTime = now;
+    playbackSpeed = std::max(0.25f, std::min(speed, 8.0f));
+}
+
+// The turn state machine: aim, shoot, simulate, resolve rules, switch player.
+// With a replay path it first loads the replay in the background and plays its shots back.
+TurnTask playTurns(std::string replayPath) {
+    std::vector<ShotRecord> script;
+    if (!replayPath.empty()) {
+        game.cueAiming = false;
+        BackgroundResult<Replay> loading = runInBackground([replayPath] { return loadReplay(replayPath); });
+        Replay replay = co_await loading;
+        if (!replay.loaded) std::cerr << "Could not load replay " << replayPath << std::endl;
+        script = replay.shots;
+        initializeGame(game);
+    }
+    // After a rewind keep the shots that led to the restored table
+    shotLog.resize(std::min(shotLog.size(), (size_t)game.shots));
+    size_t scripted = 0;
+
+    for (;;) {
+        if (game.gameOver) {
+            co_await nextTick();
+            continue;
+        }
+        turnEntry = history.record(game, true);
+
+        // Aim: replay shots first, then the computer, otherwise wait for the human to shoot
+        if (scripted < script.size()) {
+            game.cueAiming = false;
+            for (int pause = 0; pause < 30; pause++) co_await nextTick();
+            applyShot(game, script[scripted].cueAngle, script[scripted].cuePower);
+            scripted++;
+        }
+        else if (player2Computer && game.currentPlayer == 2) {
+            game.cueAiming = false;
+            computerThinking = true;
+            GameState table = game;
+            BackgroundResult<ShotRecord> search = runInBackground([table] { return chooseComputerShot(table); });
+            ShotRecord shot = co_await search;
+            computerThinking = false;
+            applyShot(game, shot.cueAngle, shot.cuePower);
+        }
+        else {
+            game.cueAiming = true;
+            bool hintSolved = false;
+            while (!game.ballsMoving) {
+                // Solve once per turn, the first time hints are wanted; the player may shoot
+                // while the solver runs, and then the hint is stale
+                if (aimHints && !hintSolved) {
+                    GameState table = game;
+                    BackgroundResult<std::vector<AimCandidate>> solving = runInBackground([table] { return findGhostBallShots(table); });
+                    std::vector<AimCandidate> candidates = co_await solving;
+                    hintSolved = true;
+                    if (game.ballsMoving) break;
+                    aimHintFound = !candidates.empty();
+                    if (aimHintFound) aimHint = candidates[0];
                 }
-                game.potted = false;
+                co_await nextTick();
             }
-            
+            aimHintFound = false;
+        }
+        shotLog.push_back({ game.cueAngle, game.cuePower });
+
+        // Resolve the whole shot at once, then show it from the recorded trajectory; the
+        // table stays in its pre-shot state until the animation ends or is skipped
+        GameState resolved = game;
+        playback = std::make_shared<const Trajectory>(recordShot(resolved, MAX_SHOT_STEPS, historySteps ? &history : nullptr));
+        playbackStep = 0.0f;
+        playbackTime = std::chrono::steady_clock::now();
+        while (playback && playbackPosition(std::chrono::steady_clock::now()) < playback->steps) {
+            co_await nextTick();
         }
+        playback.reset();
+        game = resolved; // Straight on to the next turn, so it is in the history before any input
+    }
+}
+
+TurnTask turnFlow;
+
+void restartTurnFlow(const std::string& replayPath) {
+    computerThinking = false;
+    playback.reset();
+    aimHintFound = false;
+    turnFlow = playTurns(replayPath);
+}
+
+// Copy the current game state into the render triple buffer
+void publishSnapshot() {
+    FrameSnapshot& s = renderBuffer.back();
+    s.ballCount = (int)std::min(game.balls.size(), (size_t)NUM_BALLS);
+    std::copy(game.balls.begin(), game.balls.begin() + s.ballCount, s.balls);
+    s.pocketCount = (int)std::min(game.pockets.size(), (size_t)NUM_POCKETS);
+    std::copy(game.pockets.begin(), game.pockets.begin() + s.pocketCount, s.pockets);
+    s.tableWidth = game.tableWidth;
+    s.tableHeight = game.tableHeight;
+    s.cushionThickness = game.cushionThickness;
+    s.curveRadius = game.curveRadius;
+    s.cueAngle = game.cueAngle;
+    s.cuePower = game.cuePower;
+    s.cueLength = game.cueLength;
+    s.cueAiming = game.cueAiming;
+    s.ballsMoving = game.ballsMoving;
+    s.gameOver = game.gameOver;
+    s.currentPlayer = game.currentPlayer;
+    s.player1Score = game.player1Score;
+    s.player2Score = game.player2Score;
+    s.shots = game.shots;
+    s.winner = game.winner;
+    s.computerThinking = computerThinking;
+    s.hintVisible = aimHints && aimHintFound;
+    if (s.hintVisible) {
+        s.hintGhostX = aimHint.ghostX;
+        s.hintGhostY = aimHint.ghostY;
+        s.hintPower = aimHint.cuePower / game.maxCuePower;
+    }
+    s.playback = playback;
+    s.playbackStep = playbackStep;
+    s.playbackTime = playbackTime;
+    s.playbackSpeed = playbackSpeed;
+    renderBuffer.publish();
+}
+
+SharedTable* sharedTable = nullptr; // Simulation thread only, null when the segment could not be made
+std::string sharedTableName;
+uint64_t sharedTableSteps = 0;
+
+void openSharedTable() {
+    sharedTableName = SHARED_TABLE_NAME;
+    int fd = shm_open(sharedTableName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0 && errno == EEXIST) {
+        std::string taken = sharedTableName;
+        sharedTableName += "-" + std::to_string(getpid());
+        fd = shm_open(sharedTableName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+        if (fd >= 0) {
+            std::cerr << "Shared table " << taken << " is in use; publishing to " << sharedTableName << " (game --watch HZ "
+                      << sharedTableName << ")" << std::endl;
+        }
+    }
+    if (fd < 0) {
+        std::cerr << "Shared table disabled: shm_open " << sharedTableName << ": " << strerror(errno) << std::endl;
+        return;
+    }
+    void* mapping = MAP_FAILED;
+    if (ftruncate(fd, sizeof(SharedTable)) == 0) {
+        mapping = mmap(nullptr, sizeof(SharedTable), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        std::cerr << "Shared table disabled: " << strerror(errno) << std::endl;
+        shm_unlink(sharedTableName.c_str());
+        return;
+    }
+
+    // The segment is new and zero-filled, but a reader may map it as soon as it is sized
+    sharedTable = static_cast<SharedTable*>(mapping);
+    uint64_t sequence = sharedTable->sequence.load(std::memory_order_relaxed);
+    sharedTable->sequence.store(sequence | 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    sharedTable->magic = SHARED_TABLE_MAGIC;
+    sharedTable->version = SHARED_TABLE_VERSION;
+    sharedTable->size = sizeof(SharedTable);
+    sharedTable->reserved = 0;
+    memset(&sharedTable->state, 0, sizeof(SharedTableState));
+    sharedTable->sequence.store((sequence | 1) + 1, std::memory_order_release);
+}
+
+void closeSharedTable() {
+    if (!sharedTable) return;
+    munmap(sharedTable, sizeof(SharedTable));
+    shm_unlink(sharedTableName.c_str()); // Readers keep their mapping; new ones see no game running
+    sharedTable = nullptr;
+}
+
+// Write the table after a step (simulation thread)
+void publishSharedTable() {
+    if (!sharedTable) return;
+
+    // Build the state first so the write window is one copy
+    SharedTableState state;
+    Ball balls[NUM_BALLS];
+    int count = (int)std::min(game.balls.size(), (size_t)NUM_BALLS);
+    std::copy(game.balls.begin(), game.balls.begin() + count, balls);
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (playback) playback->sample(playbackPosition(now), balls, count);
+    state.step = ++sharedTableSteps;
+    state.publishedNanos = std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
+    state.player1Score = game.player1Score;
+    state.player2Score = game.player2Score;
+    state.currentPlayer = game.currentPlayer;
+    state.gameOver = game.gameOver;
+    state.winner = game.winner;
+    state.shots = game.shots;
+    state.ballsMoving = game.ballsMoving || playback != nullptr;
+    state.ballCount = count;
+    for (int i = 0; i < NUM_BALLS; i++) {
+        const Ball& ball = balls[i];
+        state.balls[i] = i < count ? SharedBall{ ball.x, ball.y, ball.vx, ball.vy, ball.active, i == 0 ? 0 : ball.player } : SharedBall{};
     }
 
+    uint64_t sequence = sharedTable->sequence.load(std::memory_order_relaxed);
+    sharedTable->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(&sharedTable->state, &state, sizeof(state));
+    sharedTable->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+// Go back to the start of the turn in progress, or to the turn before if this one has not started.
+// Turns the computer plays are skipped over. The history after that point is dropped and the
+// turn flow restarts from the restored table.
+void rewindTurn() {
+    bool waitingToShoot = game.cueAiming && !game.ballsMoving && !game.gameOver && !playback;
+    uint64_t target = waitingToShoot ? history.previousTurn(turnEntry) : turnEntry;
+    GameState restored = game;
+    if (!history.restore(target, restored)) return;
+    while (player2Computer && restored.currentPlayer == 2) {
+        uint64_t earlier = history.previousTurn(target);
+        if (!history.restore(earlier, restored)) return;
+        target = earlier;
+    }
+    history.truncate(target);
+    game = restored;
+    restartTurnFlow("");
+}
+
+// Apply one input event forwarded from the GLUT thread
+void handleInput(const InputEvent& event) {
+    switch (event.type) {
+    case InputType::Aim:
+        aimCue(event.x, event.y);
+        break;
+    case InputType::CuePress:
+        pressCue();
+        break;
+    case InputType::CueRelease:
+        releaseCue();
+        break;
+    case InputType::Reset:
+        // A new game: undo must not rewind into the old one
+        history.clear();
+        initializeGame(game);
+        restartTurnFlow("");
+        break;
+    case InputType::ToggleComputer:
+        player2Computer = !player2Computer;
+        break;
+    case InputType::ToggleHints:
+        aimHints = !aimHints;
+        break;
+    case InputType::SkipPlayback:
+        playback.reset();
+        break;
+    case InputType::Undo:
+        rewindTurn();
+        break;
+    case InputType::ToggleHistorySteps:
+        historySteps = !historySteps;
+        break;
+    case InputType::PlaybackSpeed:
+        setPlaybackSpeed(playbackSpeed * event.x);
+        break;
+    case InputType::SaveReplay: {
+        std::vector<ShotRecord> shots = shotLog;
+        runInBackground([shots] { return saveReplay("replay.txt", shots); });
+        break;
+    }
+    case InputType::LoadReplay:
+        history.clear();
+        restartTurnFlow("replay.txt");
+        break;
+    }
+}
+
+// Simulation thread: drain input, step physics at a fixed rate, publish a snapshot
+void simulationLoop() {
+    std::chrono::steady_clock::time_point nextStep = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point lastStepStart = nextStep;
+
+    while (simulationRunning.load(std::memory_order_acquire)) {
+        std::chrono::steady_clock::time_point stepStart = std::chrono::steady_clock::now();
+        telemetry.stepInterval.record(elapsedMicros(lastStepStart, stepStart));
+        if (stepStart - nextStep > MISSED_DEADLINE_SLACK) {
+            telemetry.missedSteps.fetch_add(1, std::memory_order_relaxed);
+        }
+        lastStepStart = stepStart;
+
+        InputEvent event;
+        while (inputQueue.pop(event)) {
+            handleInput(event);
+        }
+
+        turnFlow.tick();
+        publishSnapshot();
+        publishSharedTable();
+        telemetry.stepTime.record(elapsedMicros(stepStart, std::chrono::steady_clock::now()));
+
+        // Catch up with back-to-back steps after a hiccup, but never spiral after a long stall
+        nextStep += SIM_STEP;
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (now - nextStep > SIM_STEP * 5) {
+            nextStep = now;
+        }
+        std::this_thread::sleep_until(nextStep);
+    }
+}
+
+void startSimulation() {
+    backgroundPool(); // Created before stopSimulation is registered, so it is torn down after it
+    tableField();     // Build the collision field now rather than on the first shot
+    restartTurnFlow("");
+    publishSnapshot();
+    openSharedTable();
+    publishSharedTable();
+    simulationRunning.store(true, std::memory_order_release);
+    simulationThread = std::thread(simulationLoop);
+}
+
+void stopSimulation() {
+    simulationRunning.store(false, std::memory_order_release);
+    if (simulationThread.joinable()) {
+        simulationThread.join();
+    }
+    closeSharedTable();
+}
+
+// Redraw timer, independent of the simulation step rate
+void redisplay(int value) {
+    flushInput(); // Anything the simulation thread had no room for last time
     glutPostRedisplay();
-    glutTimerFunc(16, update, 0); // ~60 FPS
+    glutTimerFunc(16, redisplay, 0); // ~60 FPS
 }
 
 // Keyboard function for key presses
@@ -977,16 +1367,69 @@ void keyboard(unsigned char key, int x, int y) {
     case 'r':
     case 'R':
         // Reset the game
-        initializeGame();
+        sendInput({ InputType::Reset, 0.0f, 0.0f });
+        break;
+    case 'c':
+    case 'C':
+        // Let the computer play player 2
+        sendInput({ InputType::ToggleComputer, 0.0f, 0.0f });
+        break;
+    case ' ':
+        // Skip to the end of the shot
+        sendInput({ InputType::SkipPlayback, 0.0f, 0.0f });
+        break;
+    case '+':
+    case '=':
+        sendInput({ InputType::PlaybackSpeed, 2.0f, 0.0f });
+        break;
+    case '-':
+        sendInput({ InputType::PlaybackSpeed, 0.5f, 0.0f });
+        break;
+    case 'u':
+    case 'U':
+        // Rewind a turn
+        sendInput({ InputType::Undo, 0.0f, 0.0f });
+        break;
+    case 'v':
+    case 'V':
+        // Also keep every step of each shot in the rewind history
+        sendInput({ InputType::ToggleHistorySteps, 0.0f, 0.0f });
+        break;
+    case 'h':
+    case 'H':
+        // Show the easiest pot while aiming
+        sendInput({ InputType::ToggleHints, 0.0f, 0.0f });
+        break;
+    case 'w':
+    case 'W':
+        // Save the shots played since the last reset
+        sendInput({ InputType::SaveReplay, 0.0f, 0.0f });
+        break;
+    case 'l':
+    case 'L':
+        // Load and play back replay.txt
+        sendInput({ InputType::LoadReplay, 0.0f, 0.0f });
+        break;
+    case 't':
+    case 'T':
+        // Toggle the frame pacing overlay
+        telemetry.overlayVisible = !telemetry.overlayVisible;
+        break;
+    case 'f':
+    case 'F':
+        // Dump frame pacing percentiles
+        dumpTelemetry("frame_telemetry.txt");
         break;
     case 27: // ESC key
-        exit(0);
+        exit(0); // stopSimulation() runs from atexit
         break;
     }
 }
 
 // Reshape function
 void reshape(int width, int height) {
+    if (width <= 0 || height <= 0) return; // Minimised
+
     glViewport(0, 0, width, height); // Set the viewport to cover the entire window
     glMatrixMode(GL_PROJECTION);
     glLoadIdentity();
@@ -999,11 +1442,53 @@ void reshape(int width, int height) {
         glOrtho(-1.0 * width / height, 1.0 * width / height, -1.0, 1.0, -1.0, 1.0);
     }
 
+    // The shorter window side always spans 2 world units; re-tessellate circles for the new scale
+    pixelsPerUnit = std::min(width, height) / 2.0f;
+    circleCache.clear();
+
     glMatrixMode(GL_MODELVIEW);
 }
 
 // Main function
 int main(int argc, char** argv) {
+    // Headless modes never open a window
+    if (argc > 1 && std::string(argv[1]) == "--serve") {
+        return runShotService(argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "--bench-collisions") {
+        return runCollisionBenchmark(argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "--bench-aim") {
+        return runAimBenchmark(argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "--bench-coarse") {
+        return runCoarseBenchmark(argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "--bench-history") {
+        return runHistoryBenchmark(argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "--heatmap") {
+        return runHeatmap(argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "--calibrate") {
+        return runCalibration(argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "--record-reference") {
+        return runRecordReference(argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "--export") {
+        return runExport(argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "--verify-export") {
+        return runVerifyExport(argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "--host") {
+        return runMatchHost(argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "--watch") {
+        return runWatch(argc, argv);
+    }
+
     // Initialize GLUT
     glutInit(&argc, argv);
     glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB);
@@ -1016,13 +1501,15 @@ int main(int argc, char** argv) {
     glutMotionFunc(mouseMotion);
     glutPassiveMotionFunc(mouseMotion);
     glutMouseFunc(mouseClick);
-    glutTimerFunc(16, update, 0);
+    glutTimerFunc(16, redisplay, 0);
 
     // Set clear color
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 
-    // Initialize game
-    initializeGame();
+    // Initialize game and hand it to the simulation thread
+    initializeGame(game);
+    startSimulation();
+    std::atexit(stopSimulation); // GLUT exits the process instead of returning
 
     // Start the main loop
     glutMainLoop();
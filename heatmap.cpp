@@ -0,0 +1,203 @@
+#include "tools.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Trajectory heatmaps (game --heatmap [--shots N] [--threads N] [--seed N] [--out PREFIX])
+//
+// Plays random shots in random games on every core and accumulates three density grids:
+// where moving balls travel, where they strike the cushions, and the direction each pocket
+// is entered from. Every thread fills its own grids, which are summed at the end by a
+// parallel reduction over grid rows, so workers never contend on shared counters.
+// Each grid is written as PREFIX_<name>.pgm (log-scaled greyscale) and PREFIX_<name>.bin
+// (magic "HEATMAP1", u32 width, u32 height, then width * height u64 counts, bottom row first).
+
+const int HEATMAP_CELLS_X = 400; // 5 mm cells on the 2.0 x 1.0 table
+const int HEATMAP_CELLS_Y = 200;
+const int POCKET_ANGLE_BINS = 72; // 5 degree bins, one row per pocket
+
+struct DensityGrid {
+    int width = 0;
+    int height = 0;
+    std::vector<uint64_t> counts; // 64-bit: one thread's run can pass 2^32 steps in a busy cell
+
+    void resize(int w, int h) {
+        width = w;
+        height = h;
+        counts.assign((size_t)w * h, 0);
+    }
+
+    void add(int x, int y) {
+        x = std::max(0, std::min(x, width - 1));
+        y = std::max(0, std::min(y, height - 1));
+        counts[(size_t)y * width + x]++;
+    }
+};
+
+// Per-thread accumulator; also the observer that sees cushion hits and pocket entries
+class HeatmapRecorder : public ShotObserver {
+public:
+    DensityGrid occupancy;
+    DensityGrid cushion;
+    DensityGrid pocketAngles;
+    uint64_t ballSteps = 0;
+
+    explicit HeatmapRecorder(const GameState& table) : pockets(table.pockets) {
+        left = -table.tableWidth / 2;
+        bottom = -table.tableHeight / 2;
+        cellWidth = table.tableWidth / HEATMAP_CELLS_X;
+        cellHeight = table.tableHeight / HEATMAP_CELLS_Y;
+        occupancy.resize(HEATMAP_CELLS_X, HEATMAP_CELLS_Y);
+        cushion.resize(HEATMAP_CELLS_X, HEATMAP_CELLS_Y);
+        pocketAngles.resize(POCKET_ANGLE_BINS, (int)table.pockets.size());
+    }
+
+    void recordStep(const GameState& g) {
+        for (const Ball& ball : g.balls) {
+            if (!ball.active || (ball.vx == 0.0f && ball.vy == 0.0f)) continue;
+            addPoint(occupancy, ball.x, ball.y);
+            ballSteps++;
+        }
+    }
+
+    void cushionHit(const Ball& ball, float normalX, float normalY) override {
+        // Contact point is one radius from the centre, against the normal
+        addPoint(cushion, ball.x - normalX * ball.radius, ball.y - normalY * ball.radius);
+    }
+
+    void pocketed(int /*index*/, const Ball& ball) override {
+        int nearest = 0;
+        float nearestDistance = 1e9f;
+        for (size_t k = 0; k < pockets.size(); k++) {
+            float dx = ball.x - pockets[k].x, dy = ball.y - pockets[k].y;
+            if (dx * dx + dy * dy < nearestDistance) {
+                nearestDistance = dx * dx + dy * dy;
+                nearest = (int)k;
+            }
+        }
+        float angle = atan2(ball.vy, ball.vx); // Direction of travel, -PI..PI
+        int bin = (int)((angle + PI) / (2 * PI) * POCKET_ANGLE_BINS);
+        pocketAngles.add(bin, nearest);
+    }
+
+private:
+    void addPoint(DensityGrid& grid, float x, float y) {
+        grid.add((int)((x - left) / cellWidth), (int)((y - bottom) / cellHeight));
+    }
+
+    std::vector<Pocket> pockets;
+    float left, bottom, cellWidth, cellHeight;
+};
+
+// Sum one grid across all recorders, each thread taking a band of rows
+std::vector<uint64_t> reduceGrids(const std::vector<const DensityGrid*>& grids, int threadCount) {
+    const DensityGrid& shape = *grids[0];
+    std::vector<uint64_t> total((size_t)shape.width * shape.height, 0);
+    std::vector<std::thread> reducers;
+    int rowsPerThread = (shape.height + threadCount - 1) / threadCount;
+    for (int t = 0; t < threadCount; t++) {
+        reducers.emplace_back([&, t] {
+            size_t begin = (size_t)std::min(shape.height, t * rowsPerThread) * shape.width;
+            size_t end = (size_t)std::min(shape.height, (t + 1) * rowsPerThread) * shape.width;
+            for (const DensityGrid* grid : grids) {
+                for (size_t i = begin; i < end; i++) total[i] += grid->counts[i];
+            }
+        });
+    }
+    for (std::thread& reducer : reducers) reducer.join();
+    return total;
+}
+
+bool writeHeatmap(const std::string& prefix, const std::string& name, int width, int height, const std::vector<uint64_t>& counts) {
+    std::ofstream bin(prefix + "_" + name + ".bin", std::ios::binary);
+    bin.write("HEATMAP1", 8);
+    uint32_t dimensions[2] = { (uint32_t)width, (uint32_t)height };
+    bin.write((const char*)dimensions, sizeof(dimensions));
+    bin.write((const char*)counts.data(), counts.size() * sizeof(uint64_t));
+
+    // Log scale so cold cells stay visible next to the rack spot; top row of the image is the top rail
+    uint64_t peak = std::max<uint64_t>(1, *std::max_element(counts.begin(), counts.end()));
+    std::ofstream pgm(prefix + "_" + name + ".pgm", std::ios::binary);
+    pgm << "P5\n" << width << " " << height << "\n255\n";
+    std::vector<unsigned char> row(width);
+    for (int y = height - 1; y >= 0; y--) {
+        for (int x = 0; x < width; x++) {
+            double value = log1p((double)counts[(size_t)y * width + x]) / log1p((double)peak);
+            row[x] = (unsigned char)(value * 255.0 + 0.5);
+        }
+        pgm.write((const char*)row.data(), width);
+    }
+    return bin.good() && pgm.good();
+}
+
+int runHeatmap(int argc, char** argv) {
+    long long shotCount = 100000;
+    int threadCount = (int)std::max(1u, std::thread::hardware_concurrency());
+    unsigned seed = 1;
+    std::string prefix = "heatmap";
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--shots" && i + 1 < argc) shotCount = std::max(1LL, atoll(argv[++i]));
+        else if (arg == "--threads" && i + 1 < argc) threadCount = std::max(1, atoi(argv[++i]));
+        else if (arg == "--seed" && i + 1 < argc) seed = (unsigned)strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--out" && i + 1 < argc) prefix = argv[++i];
+        else {
+            std::cerr << "Usage: " << argv[0] << " --heatmap [--shots N] [--threads N] [--seed N] [--out PREFIX]" << std::endl;
+            return 2;
+        }
+    }
+
+    GameState table;
+    initializeGame(table);
+    tableField();
+
+    std::vector<std::unique_ptr<HeatmapRecorder>> recorders;
+    for (int t = 0; t < threadCount; t++) recorders.emplace_back(new HeatmapRecorder(table));
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threadCount; t++) {
+        long long share = shotCount / threadCount + (t < shotCount % threadCount ? 1 : 0);
+        workers.emplace_back([&, t, share] {
+            HeatmapRecorder& recorder = *recorders[t];
+            RandomPlay play(seed * 7919u + (unsigned)t);
+            GameState g = table;
+            g.observer = &recorder;
+            for (long long shot = 0; shot < share; shot++) {
+                play.playShot(g, ignoreTable, [&](const GameState& step) { recorder.recordStep(step); });
+            }
+        });
+    }
+    for (std::thread& worker : workers) worker.join();
+    double simulateSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    uint64_t ballSteps = 0;
+    std::vector<const DensityGrid*> occupancy, cushion, pocketAngles;
+    for (const std::unique_ptr<HeatmapRecorder>& recorder : recorders) {
+        ballSteps += recorder->ballSteps;
+        occupancy.push_back(&recorder->occupancy);
+        cushion.push_back(&recorder->cushion);
+        pocketAngles.push_back(&recorder->pocketAngles);
+    }
+    bool written = writeHeatmap(prefix, "occupancy", HEATMAP_CELLS_X, HEATMAP_CELLS_Y, reduceGrids(occupancy, threadCount)) &&
+                   writeHeatmap(prefix, "cushion", HEATMAP_CELLS_X, HEATMAP_CELLS_Y, reduceGrids(cushion, threadCount)) &&
+                   writeHeatmap(prefix, "pocket_angles", POCKET_ANGLE_BINS, (int)table.pockets.size(), reduceGrids(pocketAngles, threadCount));
+    double totalSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << shotCount << " shots, " << ballSteps << " ball-steps on " << threadCount << " threads in " << simulateSeconds << " s ("
+              << ballSteps / simulateSeconds / 1e6 << " M ball-steps/s); reduce and write " << totalSeconds - simulateSeconds << " s" << std::endl;
+    if (!written) {
+        std::cerr << "Could not write heatmaps with prefix " << prefix << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,61 @@
+#include "history.h"
+
+#include <cstring>
+
+void saveImage(const GameState& g, TableImage& image) {
+    memset(&image, 0, sizeof(image)); // Padding and unused balls must compare equal
+    for (int i = 0; i < NUM_BALLS && i < (int)g.balls.size(); i++) {
+        const Ball& ball = g.balls[i];
+        image.balls[i] = { ball.x, ball.y, ball.vx, ball.vy, ball.active ? 1 : 0, ball.player };
+    }
+    image.cueAngle = g.cueAngle;
+    image.cuePower = g.cuePower;
+    image.activeBalls = g.activeBalls;
+    image.player1Score = g.player1Score;
+    image.player2Score = g.player2Score;
+    image.shots = g.shots;
+    image.currentPlayer = g.currentPlayer;
+    image.winner = g.winner;
+    image.pottedMask = g.pottedMask;
+    image.ballsMoving = g.ballsMoving;
+    image.cueAiming = g.cueAiming;
+    image.gameOver = g.gameOver;
+    image.player1Solids = g.player1Solids;
+    image.player2Solids = g.player2Solids;
+    image.ballTypeAssigned = g.ballTypeAssigned;
+    image.potted = g.potted;
+    image.foul = g.foul;
+    strncpy(image.message, g.message.c_str(), sizeof(image.message) - 1);
+}
+
+void loadImage(const TableImage& image, GameState& g) {
+    for (int i = 0; i < NUM_BALLS && i < (int)g.balls.size(); i++) {
+        Ball& ball = g.balls[i];
+        const TableImage::BallState& state = image.balls[i];
+        ball.x = state.x;
+        ball.y = state.y;
+        ball.vx = state.vx;
+        ball.vy = state.vy;
+        ball.active = state.active != 0;
+        ball.player = state.player;
+    }
+    g.cueAngle = image.cueAngle;
+    g.cuePower = image.cuePower;
+    g.activeBalls = image.activeBalls;
+    g.player1Score = image.player1Score;
+    g.player2Score = image.player2Score;
+    g.shots = image.shots;
+    g.currentPlayer = image.currentPlayer;
+    g.winner = image.winner;
+    g.pottedMask = image.pottedMask;
+    g.ballsMoving = image.ballsMoving;
+    g.cueAiming = image.cueAiming;
+    g.cueDragging = false;
+    g.gameOver = image.gameOver;
+    g.player1Solids = image.player1Solids;
+    g.player2Solids = image.player2Solids;
+    g.ballTypeAssigned = image.ballTypeAssigned;
+    g.potted = image.potted;
+    g.foul = image.foul;
+    g.message = image.message;
+}
@@ -0,0 +1,206 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "physics.h"
+
+// Rewind history in a fixed amount of memory. Every entry is the table at one moment (the start
+// of a turn, or optionally one step of a shot) reduced to a TableImage. Every HISTORY_KEYFRAME_GAP
+// entries the whole image is stored; in between only the 32-bit words that changed since the
+// previous entry, XORed against it, behind a bitmap of which words those are. Entries go into a
+// byte ring and a descriptor ring of fixed size, so the oldest ones are dropped (a keyframe and
+// its deltas at a time) instead of the history growing. Restoring an entry replays at most
+// HISTORY_KEYFRAME_GAP - 1 deltas onto its keyframe.
+
+const int HISTORY_KEYFRAME_GAP = 32;
+
+// Everything about a GameState that changes during play, as plain words
+struct TableImage {
+    struct BallState {
+        float x, y, vx, vy;
+        int32_t active;
+        int32_t player;
+    } balls[NUM_BALLS];
+    float cueAngle, cuePower;
+    int32_t activeBalls, player1Score, player2Score, shots, currentPlayer, winner;
+    uint32_t pottedMask;
+    uint8_t ballsMoving, cueAiming, gameOver, player1Solids, player2Solids, ballTypeAssigned, potted, foul;
+    char message[64]; // Truncated; only shown on screen
+};
+
+const int IMAGE_WORDS = sizeof(TableImage) / sizeof(uint32_t);
+const int IMAGE_MASK_WORDS = (IMAGE_WORDS + 63) / 64;
+static_assert(sizeof(TableImage) % sizeof(uint32_t) == 0, "TableImage must be whole words");
+
+void saveImage(const GameState& g, TableImage& image);
+// Table geometry, ball sizes and colours are left as they are in g
+void loadImage(const TableImage& image, GameState& g);
+
+class GameHistory {
+public:
+    GameHistory(size_t capacityBytes, size_t capacityEntries)
+        : ring(capacityBytes), entries(capacityEntries) {}
+
+    // Entry ids only ever grow; [first(), end()) are the ones still held
+    uint64_t first() const { return firstId; }
+    uint64_t end() const { return endId; }
+    size_t bytesUsed() const { return (size_t)(head - tail); }
+    size_t capacityBytes() const { return ring.size(); }
+
+    uint64_t record(const GameState& g, bool turnStart) {
+        TableImage image;
+        saveImage(g, image);
+        const uint32_t* words = (const uint32_t*)&image;
+        const uint32_t* previous = (const uint32_t*)&last;
+
+        // Sparse XOR against the previous entry
+        bool keyframe = endId == firstId || sinceKeyframe + 1 >= HISTORY_KEYFRAME_GAP;
+        if (!keyframe) {
+            uint64_t mask[IMAGE_MASK_WORDS] = {};
+            scratch.clear();
+            for (int w = 0; w < IMAGE_WORDS; w++) {
+                uint32_t change = words[w] ^ previous[w];
+                if (change == 0) continue;
+                mask[w / 64] |= 1ull << (w % 64);
+                scratch.push_back(change);
+            }
+            size_t size = sizeof(mask) + scratch.size() * sizeof(uint32_t);
+            makeRoom(size);
+            // Dropping old entries may have taken this delta's keyframe with it
+            keyframe = endId == firstId;
+            if (!keyframe) {
+                append(mask, sizeof(mask), size, false, turnStart);
+                write(scratch.data(), scratch.size() * sizeof(uint32_t));
+                sinceKeyframe++;
+            }
+        }
+        if (keyframe) {
+            makeRoom(sizeof(image));
+            append(&image, sizeof(image), sizeof(image), true, turnStart);
+            sinceKeyframe = 0;
+        }
+        last = image;
+        return endId - 1;
+    }
+
+    bool restore(uint64_t id, GameState& g) const {
+        TableImage image;
+        if (!imageAt(id, image)) return false;
+        loadImage(image, g);
+        return true;
+    }
+
+    // Latest turn start before the given entry, or end() if none is held
+    uint64_t previousTurn(uint64_t before) const {
+        for (uint64_t id = std::min(before, endId); id-- > firstId;) {
+            if (entryFor(id).turnStart) return id;
+        }
+        return endId;
+    }
+
+    // Forget id and everything after it, e.g. after rewinding to an earlier turn
+    void truncate(uint64_t id) {
+        if (id >= endId) return;
+        if (id <= firstId) {
+            firstId = endId = id;
+            tail = head;
+            sinceKeyframe = 0;
+            return;
+        }
+        head = entryFor(id).offset;
+        endId = id;
+        imageAt(endId - 1, last);
+        sinceKeyframe = 0;
+        for (uint64_t k = endId - 1; !entryFor(k).keyframe; k--) sinceKeyframe++;
+    }
+
+    // Forget everything held, e.g. when a new game starts; ids carry on from end()
+    void clear() {
+        firstId = endId;
+        tail = head;
+        sinceKeyframe = 0;
+    }
+
+private:
+    struct Entry {
+        uint64_t offset; // Monotonic byte position; ring index is offset % ring.size()
+        uint32_t size;
+        bool keyframe;
+        bool turnStart;
+    };
+
+    const Entry& entryFor(uint64_t id) const { return entries[id % entries.size()]; }
+
+    bool imageAt(uint64_t id, TableImage& image) const {
+        if (id < firstId || id >= endId) return false;
+        uint64_t key = id;
+        while (!entryFor(key).keyframe) key--;
+        read(entryFor(key).offset, &image, sizeof(image));
+
+        uint32_t* words = (uint32_t*)&image;
+        uint32_t changes[IMAGE_WORDS];
+        for (uint64_t k = key + 1; k <= id; k++) {
+            const Entry& entry = entryFor(k);
+            uint64_t mask[IMAGE_MASK_WORDS];
+            read(entry.offset, mask, sizeof(mask));
+            read(entry.offset + sizeof(mask), changes, entry.size - sizeof(mask));
+            size_t next = 0;
+            for (int m = 0; m < IMAGE_MASK_WORDS; m++) {
+                for (uint64_t bits = mask[m]; bits != 0; bits &= bits - 1) {
+                    words[m * 64 + __builtin_ctzll(bits)] ^= changes[next++];
+                }
+            }
+        }
+        return true;
+    }
+
+    // Drop the oldest keyframe groups until size more bytes and one more entry fit
+    void makeRoom(size_t size) {
+        while (endId > firstId && (head - tail + size > ring.size() || endId - firstId >= entries.size())) {
+            do {
+                firstId++;
+            } while (firstId < endId && !entryFor(firstId).keyframe);
+            tail = firstId < endId ? entryFor(firstId).offset : head;
+        }
+    }
+
+    void append(const void* bytes, size_t count, size_t size, bool keyframe, bool turnStart) {
+        entries[endId % entries.size()] = { head, (uint32_t)size, keyframe, turnStart };
+        endId++;
+        write(bytes, count);
+    }
+
+    void write(const void* bytes, size_t count) {
+        const uint8_t* source = (const uint8_t*)bytes;
+        for (size_t done = 0; done < count;) {
+            size_t at = (size_t)(head % ring.size());
+            size_t part = std::min(count - done, ring.size() - at);
+            memcpy(ring.data() + at, source + done, part);
+            head += part;
+            done += part;
+        }
+    }
+
+    void read(uint64_t offset, void* bytes, size_t count) const {
+        uint8_t* target = (uint8_t*)bytes;
+        for (size_t done = 0; done < count;) {
+            size_t at = (size_t)((offset + done) % ring.size());
+            size_t part = std::min(count - done, ring.size() - at);
+            memcpy(target + done, ring.data() + at, part);
+            done += part;
+        }
+    }
+
+    std::vector<uint8_t> ring;
+    std::vector<Entry> entries;
+    std::vector<uint32_t> scratch;
+    TableImage last;
+    uint64_t firstId = 0;
+    uint64_t endId = 0;
+    uint64_t head = 0; // Bytes ever written
+    uint64_t tail = 0; // Start of the oldest entry still held
+    int sinceKeyframe = 0;
+};
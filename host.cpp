@@ -0,0 +1,243 @@
+#include "latency.h"
+#include "tools.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Multi-match host (game --host [--matches N] [--threads N] [--seconds S] [--seed N] [--fast])
+//
+// Runs many independent matches on one fixed 60 Hz clock. Only tables with balls moving are
+// scheduled: a table waiting for its player is just an entry in the wake-up heap and costs
+// nothing per tick. Every table has a home worker that allocated it and steps it each tick,
+// so its state stays in that core's cache. A worker that finishes its own shard claims tables
+// from the other shards through the same atomic cursor, so a burst of breaks landing on one
+// shard is spread over the whole pool. The built-in load generator plays random shots after
+// random thinking times; --fast runs the ticks back to back instead of in real time.
+
+struct HostedMatch {
+    GameState state;
+    RandomPlay play; // The match's shots and thinking times
+};
+
+struct alignas(64) HostShard {
+    std::vector<int> ready;          // Tables homed here that step this tick
+    std::atomic<size_t> claimed{0};  // Shared by the owner and thieves
+};
+
+// Per-worker output of one tick, merged by the clock thread
+struct alignas(64) HostWorkerResult {
+    std::vector<int> moving;         // Still rolling after the step
+    std::vector<int> settled;        // Stopped (turn resolved) or game over
+    uint64_t steps = 0;
+    uint64_t stolen = 0;
+};
+
+class MatchHost {
+public:
+    MatchHost(int matchCount, int threadCount, unsigned seed)
+        : shards(threadCount), results(threadCount), matches(matchCount), homes(matchCount) {
+        GameState rack;
+        initializeGame(rack);
+        for (int i = 0; i < matchCount; i++) homes[i] = i % threadCount;
+        for (int t = 0; t < threadCount; t++) {
+            workers.emplace_back(&MatchHost::workerLoop, this, t, rack, seed);
+        }
+        // Wait for every worker to allocate its own tables
+        std::unique_lock<std::mutex> lock(mutex);
+        tickDone.wait(lock, [this] { return started == (int)workers.size(); });
+    }
+
+    ~MatchHost() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        tickStart.notify_all();
+        for (std::thread& worker : workers) worker.join();
+    }
+
+    HostedMatch& match(int index) { return *matches[index]; }
+    int home(int index) const { return homes[index]; }
+    HostShard& shard(int worker) { return shards[worker]; }
+    HostWorkerResult& result(int worker) { return results[worker]; }
+    int threadCount() const { return (int)workers.size(); }
+
+    // Step every table in the shards' ready lists once and wait for all workers
+    void tick() {
+        for (HostShard& shard : shards) shard.claimed.store(0, std::memory_order_relaxed);
+        for (HostWorkerResult& result : results) {
+            result.moving.clear();
+            result.settled.clear();
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+        running = (int)workers.size();
+        tickNumber++;
+        tickStart.notify_all();
+        tickDone.wait(lock, [this] { return running == 0; });
+    }
+
+private:
+    void workerLoop(int worker, GameState rack, unsigned seed) {
+        // First touch from the home thread keeps each table's memory local to its worker
+        for (int i = worker; i < (int)matches.size(); i += (int)shards.size()) {
+            matches[i].reset(new HostedMatch{ rack, RandomPlay(seed * 7919u + (unsigned)i, 0.3f) });
+        }
+        uint64_t seen = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            started++;
+        }
+        tickDone.notify_all();
+
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                tickStart.wait(lock, [&] { return stopping || tickNumber != seen; });
+                if (stopping) return;
+                seen = tickNumber;
+            }
+
+            // Own shard first, then help whichever shards still have tables left
+            HostWorkerResult& out = results[worker];
+            for (int k = 0; k < (int)shards.size(); k++) {
+                HostShard& shard = shards[(worker + k) % shards.size()];
+                for (;;) {
+                    size_t next = shard.claimed.fetch_add(1, std::memory_order_relaxed);
+                    if (next >= shard.ready.size()) break;
+                    int index = shard.ready[next];
+                    GameState& g = matches[index]->state;
+                    update(g);
+                    out.steps++;
+                    if (k != 0) out.stolen++;
+                    if (g.ballsMoving && !g.gameOver) out.moving.push_back(index);
+                    else out.settled.push_back(index);
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--running == 0) tickDone.notify_all();
+        }
+    }
+
+    std::vector<HostShard> shards;
+    std::vector<HostWorkerResult> results;
+    std::vector<std::unique_ptr<HostedMatch>> matches;
+    std::vector<int> homes;
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable tickStart;
+    std::condition_variable tickDone;
+    uint64_t tickNumber = 0;
+    int running = 0;
+    int started = 0;
+    bool stopping = false;
+};
+
+int runMatchHost(int argc, char** argv) {
+    int matchCount = 500;
+    int threadCount = (int)std::max(1u, std::thread::hardware_concurrency());
+    double seconds = 10.0;
+    unsigned seed = 1;
+    bool fast = false;
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--matches" && i + 1 < argc) matchCount = std::max(1, atoi(argv[++i]));
+        else if (arg == "--threads" && i + 1 < argc) threadCount = std::max(1, atoi(argv[++i]));
+        else if (arg == "--seconds" && i + 1 < argc) seconds = std::max(0.1, atof(argv[++i]));
+        else if (arg == "--seed" && i + 1 < argc) seed = (unsigned)strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--fast") fast = true;
+        else {
+            std::cerr << "Usage: " << argv[0] << " --host [--matches N] [--threads N] [--seconds S] [--seed N] [--fast]" << std::endl;
+            return 2;
+        }
+    }
+
+    // Load generator: players think for 1-6 s between shots, so most tables are idle at any time
+    const int minThinkTicks = 60;
+    const int maxThinkTicks = 360;
+    tableField();
+    MatchHost host(matchCount, threadCount, seed);
+
+    typedef std::pair<long long, int> Wakeup; // (tick, match)
+    std::priority_queue<Wakeup, std::vector<Wakeup>, std::greater<Wakeup>> wakeups;
+    std::mt19937 random(seed);
+    for (int i = 0; i < matchCount; i++) {
+        wakeups.push({ std::uniform_int_distribution<int>(0, maxThinkTicks)(random), i });
+    }
+
+    LatencyHistogram stepLatency;
+    uint64_t steps = 0, stolen = 0, shots = 0, games = 0;
+    double busySeconds = 0.0;
+    long long tickCount = (long long)(seconds * 1e6 / SIM_STEP.count());
+    size_t peakMoving = 0;
+    std::vector<int> moving;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point nextTick = start;
+    for (long long tick = 0; tick < tickCount; tick++) {
+        // Players whose thinking time is up take their shot
+        while (!wakeups.empty() && wakeups.top().first <= tick) {
+            int index = wakeups.top().second;
+            wakeups.pop();
+            HostedMatch& match = host.match(index);
+            if (match.play.continueGame(match.state)) games++;
+            match.play.shoot(match.state);
+            moving.push_back(index);
+            shots++;
+        }
+
+        for (int t = 0; t < host.threadCount(); t++) host.shard(t).ready.clear();
+        for (int index : moving) host.shard(host.home(index)).ready.push_back(index);
+        peakMoving = std::max(peakMoving, moving.size());
+
+        std::chrono::steady_clock::time_point tickStart = std::chrono::steady_clock::now();
+        host.tick();
+        std::chrono::steady_clock::time_point tickEnd = std::chrono::steady_clock::now();
+        stepLatency.record(elapsedMicros(tickStart, tickEnd));
+        busySeconds += std::chrono::duration<double>(tickEnd - tickStart).count();
+
+        moving.clear();
+        for (int t = 0; t < host.threadCount(); t++) {
+            HostWorkerResult& result = host.result(t);
+            moving.insert(moving.end(), result.moving.begin(), result.moving.end());
+            for (int index : result.settled) {
+                std::mt19937& thinking = host.match(index).play.random; // Per match, so the load does not depend on thread count
+                wakeups.push({ tick + std::uniform_int_distribution<int>(minThinkTicks, maxThinkTicks)(thinking), index });
+            }
+            steps += result.steps;
+            stolen += result.stolen;
+            result.steps = 0;
+            result.stolen = 0;
+        }
+
+        if (!fast) {
+            nextTick += SIM_STEP;
+            std::this_thread::sleep_until(nextTick);
+        }
+    }
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Capacity: how many such matches each core could carry if ticks used the whole 60 Hz budget
+    double budgetUsed = busySeconds / tickCount / (SIM_STEP.count() / 1e6);
+    double perCore = (double)matchCount / threadCount;
+    std::cout << matchCount << " matches on " << threadCount << " threads, " << tickCount << " ticks in " << wallSeconds << " s"
+              << (fast ? " (fast)" : "") << "\n"
+              << shots << " shots, " << games << " new games, " << steps << " table steps (" << (double)steps / tickCount
+              << " tables moving per tick on average, peak " << peakMoving << "), " << stolen << " stolen\n"
+              << "step latency: p50 " << stepLatency.percentile(50) << "us  p99 " << stepLatency.percentile(99)
+              << "us  max " << stepLatency.max() << "us  (" << budgetUsed * 100.0 << "% of the tick budget)\n"
+              << "matches per core: " << perCore << " hosted, ~" << (budgetUsed > 0.0 ? perCore / budgetUsed : 0.0)
+              << " at full budget" << std::endl;
+    return 0;
+}
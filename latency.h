@@ -0,0 +1,66 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+
+// Fixed-size log-linear histogram of durations in microseconds.
+// Exact below 64us, then 16 sub-buckets per power of two (~6% resolution) up to ~16s.
+// record() is a single relaxed atomic increment, so any thread may call it.
+class LatencyHistogram {
+public:
+    static const int LINEAR_BUCKETS = 64;
+    static const int SUB_BUCKETS = 16;
+    static const int NUM_BUCKETS = LINEAR_BUCKETS + (24 - 6) * SUB_BUCKETS;
+
+    void record(uint64_t micros) {
+        counts[bucketFor(micros)].fetch_add(1, std::memory_order_relaxed);
+        total.fetch_add(1, std::memory_order_relaxed);
+        uint64_t seen = maximum.load(std::memory_order_relaxed);
+        while (micros > seen && !maximum.compare_exchange_weak(seen, micros, std::memory_order_relaxed)) {
+        }
+    }
+
+    // Upper bound of the bucket holding the given percentile (0-100)
+    uint64_t percentile(double p) const {
+        uint64_t n = total.load(std::memory_order_relaxed);
+        if (n == 0) return 0;
+        uint64_t rank = (uint64_t)std::ceil(p / 100.0 * n);
+        if (rank == 0) rank = 1;
+        uint64_t seen = 0;
+        for (int i = 0; i < NUM_BUCKETS; i++) {
+            seen += counts[i].load(std::memory_order_relaxed);
+            if (seen >= rank) return i == NUM_BUCKETS - 1 ? max() : std::min(bucketLimit(i), max());
+        }
+        return max();
+    }
+
+    uint64_t count() const { return total.load(std::memory_order_relaxed); }
+    uint64_t max() const { return maximum.load(std::memory_order_relaxed); }
+
+private:
+    static int bucketFor(uint64_t micros) {
+        if (micros < LINEAR_BUCKETS) return (int)micros;
+        int exponent = 63 - __builtin_clzll(micros); // >= 6
+        int sub = (int)((micros >> (exponent - 4)) & (SUB_BUCKETS - 1));
+        int bucket = LINEAR_BUCKETS + (exponent - 6) * SUB_BUCKETS + sub;
+        return std::min(bucket, NUM_BUCKETS - 1);
+    }
+
+    static uint64_t bucketLimit(int bucket) {
+        if (bucket < LINEAR_BUCKETS) return (uint64_t)bucket;
+        int exponent = (bucket - LINEAR_BUCKETS) / SUB_BUCKETS + 6;
+        uint64_t sub = (uint64_t)((bucket - LINEAR_BUCKETS) % SUB_BUCKETS);
+        return ((SUB_BUCKETS + sub + 1) << (exponent - 4)) - 1;
+    }
+
+    std::atomic<uint64_t> counts[NUM_BUCKETS] = {};
+    std::atomic<uint64_t> total{0};
+    std::atomic<uint64_t> maximum{0};
+};
+
+inline uint64_t elapsedMicros(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to) {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(to - from).count();
+}
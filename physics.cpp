@@ -0,0 +1,621 @@
+#include "physics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+// Initialize ball positions in triangle formation
+void initializeBalls(GameState& g) {
+    g.balls.clear();
+
+    // Colors for balls (RGB values between 0-255, will be normalized)
+    int colors[NUM_BALLS][3] = {
+        {255, 255, 255},  // Cue ball (white)
+        {255, 255, 0},    // Yellow
+        {0, 0, 255},      // Blue
+        {255, 0, 0},      // Red
+        {128, 0, 128},    // Purple
+        {255, 165, 0},    // Orange
+        {155, 131, 131},      // Green
+        {128, 0, 0},      // Maroon
+        {0, 0, 0},        // Black (8-ball)
+        {255, 255, 0},    // Yellow striped
+        {0, 0, 255},      // Blue striped
+        {255, 0, 0},      // Red striped
+        {128, 0, 128},    // Purple striped
+        {255, 165, 0},    // Orange striped
+        {58, 128, 1},      // Green striped
+        {128, 0, 0}       // Maroon striped
+    };
+
+    float ballRadius = 0.03f;
+    float spacing = ballRadius * 2.1f; // Slight gap between balls
+
+    // Create cue ball
+    Ball cueBall;
+    cueBall.x = -0.4f;
+    cueBall.y = 0.0f;
+    cueBall.vx = 0.0f;
+    cueBall.vy = 0.0f;
+    cueBall.radius = ballRadius;
+    cueBall.active = true;
+    cueBall.color[0] = colors[0][0];
+    cueBall.color[1] = colors[0][1];
+    cueBall.color[2] = colors[0][2];
+    g.balls.push_back(cueBall);
+
+    // Create other balls in triangle formation
+    float startX = 0.4f;
+    float startY = 0.0f;
+
+    int ballIndex = 1;
+    for (int row = 0; row < 5; row++) {
+        for (int col = 0; col <= row; col++) {
+            if (ballIndex < NUM_BALLS) {
+                Ball ball;
+                ball.x = startX + row * spacing * 0.866f; // 0.866 = cos(30°)
+                ball.y = startY + (col - row / 2.0f) * spacing;
+                ball.vx = 0.0f;
+                ball.vy = 0.0f;
+                ball.radius = ballRadius;
+                ball.active = true;
+                ball.color[0] = colors[ballIndex][0];
+                ball.color[1] = colors[ballIndex][1];
+                ball.color[2] = colors[ballIndex][2];
+                // Assign player based on ball type (1-7 solids, 9-15 stripes, 8 neutral)
+                if (ballIndex >= 1 && ballIndex <= 7) ball.player = -1;  // Solids (player to be determined)
+                else if (ballIndex >= 9 && ballIndex <= 15) ball.player = -2;  // Stripes (player to be determined)
+                else ball.player = 0;  // 8-ball is neutral
+                g.balls.push_back(ball);
+                ballIndex++;
+            }
+        }
+    }
+}
+
+// Initialize pockets
+void initializePockets(GameState& g) {
+    g.pockets.clear();
+
+    float pocketRadius = 0.065f; // Radius of the pockets
+    float tableWidth = g.tableWidth;
+    float tableHeight = g.tableHeight;
+
+    // Add 6 pockets (4 corners, 2 middle sides)
+    Pocket pocket;
+
+    // Top-left corner pocket (moved outward)
+    pocket.x = -tableWidth / 2 ;
+    pocket.y = tableHeight / 2;
+    pocket.radius = pocketRadius;
+    g.pockets.push_back(pocket);
+
+    // Top-middle pocket (moved outward)
+    pocket.x = 0;
+    pocket.y = tableHeight / 2 + pocketRadius / 2;
+    pocket.radius = pocketRadius;
+    g.pockets.push_back(pocket);
+
+    // Top-right corner pocket (moved outward)
+    pocket.x = tableWidth / 2  ;
+    pocket.y = tableHeight / 2 ;
+    pocket.radius = pocketRadius;
+    g.pockets.push_back(pocket);
+
+    // Bottom-right corner pocket (moved outward)
+    pocket.x = tableWidth / 2 ;
+    pocket.y = -tableHeight / 2 ;
+    pocket.radius = pocketRadius;
+    g.pockets.push_back(pocket);
+
+    // Bottom-middle pocket (moved outward)
+    pocket.x = 0;
+    pocket.y = -tableHeight / 2 - pocketRadius / 2;
+    pocket.radius = pocketRadius;
+    g.pockets.push_back(pocket);
+
+    // Bottom-left corner pocket (moved outward)
+    pocket.x = -tableWidth / 2 ;
+    pocket.y = -tableHeight / 2 ;
+    pocket.radius = pocketRadius;
+    g.pockets.push_back(pocket);
+}
+
+// Initialize the game
+void initializeGame(GameState& g) {
+    initializeBalls(g);
+    initializePockets(g);
+    g.player1Score = 0;
+    g.player2Score = 0;
+    g.shots = 0;
+    g.gameOver = false;
+    g.ballsMoving = false;
+    g.cueAiming = true;
+    g.currentPlayer = 1;
+    g.player1Solids = false;
+    g.player2Solids = false;
+    g.ballTypeAssigned = false;
+    g.potted = false;
+    g.foul = false;
+    g.message = "Player 1's turn";
+}
+
+void switchPlayer(GameState& g) {
+    if (g.currentPlayer == 1) {
+        g.currentPlayer = 2;
+        g.message = "Player 2's turn";
+    }
+    else {
+        g.currentPlayer = 1;
+        g.message = "Player 1's turn";
+    }
+    g.potted = false;
+    g.foul = false;
+}
+// Assign balls to players once the solids/stripes split is known
+void assignBallOwners(GameState& g) {
+    for (size_t i = 1; i < g.balls.size(); i++) {
+        if (i == 8) continue; // 8-ball is neutral
+
+        if (i >= 1 && i <= 7) { // Solids
+            g.balls[i].player = g.player1Solids ? 1 : 2;
+        }
+        else { // Stripes
+            g.balls[i].player = g.player1Solids ? 2 : 1;
+        }
+    }
+}
+
+void assignBallTypes(GameState& g, int pottedBallIndex) {
+    if (g.ballTypeAssigned) return;
+
+    // Determine if the potted ball is solid or striped
+    bool isSolid = (pottedBallIndex >= 1 && pottedBallIndex <= 7);
+
+    if (g.currentPlayer == 1) {
+        g.player1Solids = isSolid;
+        g.player2Solids = !isSolid;
+    }
+    else {
+        g.player2Solids = isSolid;
+        g.player1Solids = !isSolid;
+    }
+
+    assignBallOwners(g);
+    g.ballTypeAssigned = true;
+
+    // Update message to inform players of their ball types
+    if (g.player1Solids) {
+        g.message = "Player 1: Solids, Player 2: Stripes";
+    }
+    else {
+        g.message = "Player 1: Stripes, Player 2: Solids";
+    }
+}
+
+bool checkWin(GameState& g, int player) {
+    // Check if all of the player's balls are pocketed
+    for (size_t i = 1; i < g.balls.size(); i++) {
+        if (i == 8) continue; // Skip 8-ball
+
+        if (g.balls[i].player == player && g.balls[i].active) {
+            return false; // Player still has active balls
+        }
+    }
+
+    // Check if 8-ball is pocketed (should be the last ball)
+    return !g.balls[8].active;
+}
+
+bool checkLoss(GameState& g, int player) {
+    // If the player pockets the 8-ball but still has their balls on the table
+    if (!g.balls[8].active) {
+        for (size_t i = 1; i < g.balls.size(); i++) {
+            if (i == 8) continue;
+
+            if (g.balls[i].player == player && g.balls[i].active) {
+                return true; // Player pocketed 8-ball too early
+            }
+        }
+    }
+
+    // If the player pockets the cue ball and the 8-ball in the same shot
+    if (!g.balls[0].active && !g.balls[8].active) {
+        return true;
+    }
+
+    return false;
+}
+// All tables share one geometry, so the field is built once on first use
+const TableField& tableField() {
+    static const TableField field = [] {
+        GameState table;
+        initializePockets(table);
+        return TableField(table);
+    }();
+    return field;
+}
+
+// Pot ball i: the cue ball respawns, the black ends the game, anything else scores
+void pocketBall(GameState& g, size_t i) {
+    // Ball is pocketed
+    g.balls[i].active = false;
+    g.pottedMask |= 1u << i;
+    g.activeBalls--;
+    if (g.observer) g.observer->pocketed((int)i, g.balls[i]);
+
+    // Special case for cue ball - respawn it
+    if (i == 0) {
+        g.foul = true;
+        // Respawn cue ball in a legal position
+        g.balls[0].x = -0.4f;
+        g.balls[0].y = 0.0f;
+        g.balls[0].vx = 0.0f;
+        g.balls[0].vy = 0.0f;
+        g.balls[0].active = true;
+        g.activeBalls++;
+        g.message = "Foul! Scratched the cue ball";
+    }
+    // Special case for 8-ball (black ball)
+    else if (i == 8) {
+        // Check if the player has potted all their assigned balls
+        bool allAssignedBallsPotted = true;
+        for (size_t k = 1; k < g.balls.size(); k++) {
+            if (g.balls[k].player == g.currentPlayer && g.balls[k].active) {
+                allAssignedBallsPotted = false;
+                break;
+            }
+        }
+
+        if (allAssignedBallsPotted) {
+            // Player wins by potting the 8-ball after potting all their assigned balls
+            g.gameOver = true;
+            g.winner = g.currentPlayer;
+            g.message = "Player " + std::to_string(g.currentPlayer) + " wins by potting the black ball!";
+        }
+        else {
+            // Player loses for potting the 8-ball too early
+            g.gameOver = true;
+            g.winner = g.currentPlayer == 1 ? 2 : 1; // Opponent wins
+            g.message = "Player " + std::to_string(g.currentPlayer) + " loses! Potted the black ball too early.";
+        }
+    }
+    // Regular balls
+    else {
+        // Assign ball types if not already assigned
+        if (!g.ballTypeAssigned) {
+            assignBallTypes(g, i);
+        }
+
+        // Check if the player potted their own ball
+        if (g.balls[i].player == g.currentPlayer) {
+            // Add to score
+            if (g.currentPlayer == 1) {
+                g.player1Score++;
+            }
+            else {
+                g.player2Score++;
+            }
+            g.potted = true;
+            g.message = "Good shot! Go again";
+        }
+        else {
+            // Player potted opponent's ball
+            if (g.currentPlayer == 1) {
+                g.player2Score++;
+            }
+            else {
+                g.player1Score++;
+            }
+            g.message = "Potted opponent's ball";
+        }
+    }
+}
+
+// Resolve one ball-ball contact; returns true if the balls were pushed apart
+bool resolveBallPair(Ball& a, Ball& b, float elasticity) {
+    // Calculate distance between balls
+    float dx = b.x - a.x;
+    float dy = b.y - a.y;
+    float distance = sqrt(dx * dx + dy * dy);
+
+    // Check for collision
+    if (distance >= a.radius + b.radius) return false;
+
+    // Normalize the displacement vector
+    float nx = dx / distance;
+    float ny = dy / distance;
+
+    // Calculate relative velocity
+    float dvx = b.vx - a.vx;
+    float dvy = b.vy - a.vy;
+
+    // Calculate velocity along the normal
+    float velAlongNormal = dvx * nx + dvy * ny;
+
+    // Don't resolve if balls are moving away from each other
+    if (velAlongNormal > 0) return false;
+
+    // Collision response
+    float impulse = -(1 + elasticity) * velAlongNormal;
+
+    // Apply impulse to both balls
+    a.vx -= nx * impulse;
+    a.vy -= ny * impulse;
+    b.vx += nx * impulse;
+    b.vy += ny * impulse;
+
+    // Separate the balls to prevent sticking
+    float overlap = (a.radius + b.radius - distance) / 2.0f;
+    a.x -= nx * overlap;
+    a.y -= ny * overlap;
+    b.x += nx * overlap;
+    b.y += ny * overlap;
+    return true;
+}
+
+// Reference all-pairs loop, one sqrt per pair
+void handleBallCollisionsScalar(GameState& g) {
+    for (size_t i = 0; i < g.balls.size(); i++) {
+        if (!g.balls[i].active) continue;
+
+        for (size_t j = i + 1; j < g.balls.size(); j++) {
+            if (!g.balls[j].active) continue;
+            resolveBallPair(g.balls[i], g.balls[j], g.physics.ballElasticity);
+        }
+    }
+}
+
+// Narrow phase: bit j of contacts[i] (j > i) is set when active balls i and j are within
+// touching distance. The squared threshold carries a little slack so rounding can never
+// drop a pair that the exact sqrt test in resolveBallPair() would accept.
+const int CONTACT_KERNEL_BALLS = 16;
+const float CONTACT_SLACK = 1.0001f;
+
+struct ContactInput {
+    alignas(32) float x[CONTACT_KERNEL_BALLS];
+    alignas(32) float y[CONTACT_KERNEL_BALLS];
+    alignas(32) float radius[CONTACT_KERNEL_BALLS];
+    uint32_t activeMask;
+};
+
+void findContactsScalar(const ContactInput& in, uint32_t* contacts) {
+    for (int i = 0; i < CONTACT_KERNEL_BALLS; i++) {
+        uint32_t row = 0;
+        if (in.activeMask & (1u << i)) {
+            for (int j = i + 1; j < CONTACT_KERNEL_BALLS; j++) {
+                float dx = in.x[j] - in.x[i];
+                float dy = in.y[j] - in.y[i];
+                float reach = in.radius[i] + in.radius[j];
+                if (dx * dx + dy * dy < reach * reach * CONTACT_SLACK) row |= 1u << j;
+            }
+        }
+        contacts[i] = row & in.activeMask;
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// Same test, one row of 16 pairs in two 8-lane AVX2 compares
+__attribute__((target("avx2"))) void findContactsAvx2(const ContactInput& in, uint32_t* contacts) {
+    const __m256 slack = _mm256_set1_ps(CONTACT_SLACK);
+    for (int i = 0; i < CONTACT_KERNEL_BALLS; i++) {
+        if (!(in.activeMask & (1u << i))) {
+            contacts[i] = 0;
+            continue;
+        }
+        const __m256 xi = _mm256_set1_ps(in.x[i]);
+        const __m256 yi = _mm256_set1_ps(in.y[i]);
+        const __m256 ri = _mm256_set1_ps(in.radius[i]);
+        uint32_t row = 0;
+        for (int half = 0; half < CONTACT_KERNEL_BALLS / 8; half++) {
+            __m256 dx = _mm256_sub_ps(_mm256_load_ps(in.x + half * 8), xi);
+            __m256 dy = _mm256_sub_ps(_mm256_load_ps(in.y + half * 8), yi);
+            __m256 distanceSq = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+            __m256 reach = _mm256_add_ps(_mm256_load_ps(in.radius + half * 8), ri);
+            __m256 reachSq = _mm256_mul_ps(_mm256_mul_ps(reach, reach), slack);
+            uint32_t lanes = (uint32_t)_mm256_movemask_ps(_mm256_cmp_ps(distanceSq, reachSq, _CMP_LT_OQ));
+            row |= lanes << (half * 8);
+        }
+        contacts[i] = row & in.activeMask & ~((2u << i) - 1); // Upper triangle only
+    }
+}
+
+const bool cpuHasAvx2 = __builtin_cpu_supports("avx2");
+#else
+const bool cpuHasAvx2 = false;
+#endif
+
+void findContacts(const ContactInput& in, uint32_t* contacts) {
+#if defined(__x86_64__) || defined(__i386__)
+    if (cpuHasAvx2) {
+        findContactsAvx2(in, contacts);
+        return;
+    }
+#endif
+    findContactsScalar(in, contacts);
+}
+
+// Handle ball-ball collisions
+void handleBallCollisions(GameState& g) {
+    int count = (int)g.balls.size();
+    if (count > CONTACT_KERNEL_BALLS) {
+        handleBallCollisionsScalar(g);
+        return;
+    }
+
+    ContactInput in = {};
+    for (int i = 0; i < count; i++) {
+        in.x[i] = g.balls[i].x;
+        in.y[i] = g.balls[i].y;
+        in.radius[i] = g.balls[i].radius;
+        if (g.balls[i].active) in.activeMask |= 1u << i;
+    }
+    uint32_t contacts[CONTACT_KERNEL_BALLS];
+    findContacts(in, contacts);
+
+    // Resolve in the same (i, j) order as the scalar loop so results are bit-identical.
+    // The kernel saw start-of-step positions; once a resolution pushes a ball, its
+    // remaining pairs are re-tested exactly instead of trusting the mask.
+    uint32_t moved = 0;
+    for (int i = 0; i < count; i++) {
+        if (!(in.activeMask & (1u << i))) continue;
+
+        uint32_t later = in.activeMask & ~((2u << i) - 1);
+        uint32_t pending = (moved & (1u << i)) ? later : contacts[i] | (moved & later);
+
+        while (pending) {
+            int j = __builtin_ctz(pending);
+            pending &= pending - 1;
+            if (resolveBallPair(g.balls[i], g.balls[j], g.physics.ballElasticity)) {
+                moved |= (1u << i) | (1u << j);
+                pending = later & ~((2u << j) - 1); // Ball i moved: every later partner needs the exact test
+            }
+        }
+    }
+}
+
+// Push a ball that has run into the cushion back out and reflect it off the outline, jaws included
+void bounceOffCushion(GameState& g, Ball& ball, const FieldSample& sample) {
+    const float restitution = g.physics.cushionRestitution;
+
+    // Push the ball back out along the cushion normal
+    float depth = ball.radius - sample.distance;
+    ball.x += sample.normalX * depth;
+    ball.y += sample.normalY * depth;
+
+    // Reflect the velocity component heading into the cushion
+    float velAlongNormal = ball.vx * sample.normalX + ball.vy * sample.normalY;
+    if (velAlongNormal < 0) {
+        if (g.observer) g.observer->cushionHit(ball, sample.normalX, sample.normalY);
+        ball.vx -= (1 + restitution) * velAlongNormal * sample.normalX;
+        ball.vy -= (1 + restitution) * velAlongNormal * sample.normalY;
+    }
+}
+
+// Cushions, then pockets, for each active ball in mask. One field lookup per ball serves both
+// tests; only a ball the cushion pushed is looked up again, at the spot it was pushed to.
+void handleCushionsAndPockets(GameState& g, uint32_t mask) {
+    const TableField& field = tableField();
+    for (size_t i = 0; i < g.balls.size(); i++) {
+        Ball& ball = g.balls[i];
+        if (!ball.active || (i < 32 && !(mask & (1u << i)))) continue;
+
+        FieldSample sample = field.sample(ball.x, ball.y);
+        if (sample.distance < ball.radius) {
+            bounceOffCushion(g, ball, sample);
+            sample = field.sample(ball.x, ball.y);
+        }
+        if (sample.pocketDistance < 0.0f) pocketBall(g, i);
+    }
+}
+
+// Check if all balls have stopped moving
+bool allBallsStopped(GameState& g) {
+    for (size_t i = 0; i < g.balls.size(); i++) {
+        if (!g.balls[i].active) continue;
+
+        if (fabs(g.balls[i].vx) > g.physics.minVelocity || fabs(g.balls[i].vy) > g.physics.minVelocity) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Shoot the cue ball; cueAngle points from the ball towards the cue butt, as while aiming
+void applyShot(GameState& g, float cueAngle, float cuePower) {
+    g.cueAngle = cueAngle;
+    g.cuePower = std::max(0.0f, std::min(cuePower, g.maxCuePower));
+    float shotAngle = g.cueAngle + PI; // Reverse the angle
+
+    g.balls[0].vx = cos(shotAngle) * g.cuePower * SHOT_VELOCITY_FACTOR;
+    g.balls[0].vy = sin(shotAngle) * g.cuePower * SHOT_VELOCITY_FACTOR;
+
+    g.ballsMoving = true;
+    g.cueAiming = false;
+    g.cueDragging = false;
+    g.pottedMask = 0;
+    g.shots++;
+}
+
+// Move one ball along its velocity for a step, then slow it down
+void integrateBall(const GameState& g, Ball& ball) {
+    ball.x += ball.vx;
+    ball.y += ball.vy;
+
+    // Apply friction - higher value = more friction = faster slowdown
+    ball.vx *= g.physics.friction;
+    ball.vy *= g.physics.friction;
+
+    // Stop ball if velocity is very low
+    if (fabs(ball.vx) < g.physics.minVelocity) ball.vx = 0.0f;
+    if (fabs(ball.vy) < g.physics.minVelocity) ball.vy = 0.0f;
+}
+
+// Move the balls one step: integrate, collide, and pocket
+void advanceBalls(GameState& g) {
+    // Update ball positions based on velocity
+    for (size_t i = 0; i < g.balls.size(); i++) {
+        if (!g.balls[i].active) continue;
+        integrateBall(g, g.balls[i]);
+    }
+
+    // Handle collisions
+    handleBallCollisions(g);
+
+    // Cushions and pocketed balls
+    handleCushionsAndPockets(g);
+}
+
+// Resolve the turn once every ball has stopped
+void finishShot(GameState& g) {
+    g.ballsMoving = false;
+    g.cueAiming = true;
+    g.cuePower = 0.0f;
+    if (!g.potted || g.foul) {
+        switchPlayer(g);
+    }
+    g.potted = false;
+}
+
+// Update function for game logic - advances a shot by one fixed step
+void update(GameState& g) {
+    if (!g.gameOver) {
+        if (g.ballsMoving) {
+            advanceBalls(g);
+
+            // Check if all balls have stopped
+            if (allBallsStopped(g)) {
+                finishShot(g);
+            }
+        }
+    }
+}
+
+// Run update() until the balls come to rest; returns the number of steps taken
+int simulateToRest(GameState& g, int maxSteps) {
+    int steps = 0;
+    while (g.ballsMoving && !g.gameOver && steps < maxSteps) {
+        update(g);
+        steps++;
+    }
+    return steps;
+}
+
+// Score a finished trial shot from the shooter's point of view
+float scoreShotOutcome(const GameState& before, const GameState& after) {
+    int shooter = before.currentPlayer;
+    if (after.gameOver) return after.winner == shooter ? 1000.0f : -1000.0f;
+
+    float score = 0.0f;
+    for (int i = 1; i < NUM_BALLS; i++) {
+        if (!(after.pottedMask & (1u << i))) continue;
+        score += after.balls[i].player == shooter ? 10.0f : -5.0f;
+    }
+    if (after.pottedMask & 1u) score -= 20.0f; // Scratch
+    if (after.currentPlayer == shooter) score += 3.0f; // Kept the table
+    return score;
+}
@@ -0,0 +1,311 @@
+// Table, balls and rules: the simulation the game and every headless tool share
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Constants
+const float PI = 3.14159f;
+const int NUM_BALLS = 16; // 15 colored balls + 1 cue ball
+const int NUM_POCKETS = 6;
+const std::chrono::microseconds SIM_STEP(16667); // Physics runs at a fixed 60 Hz
+const int MAX_SHOT_STEPS = 20000; // Safety cap; a full power break settles in ~1500 steps
+const float SHOT_VELOCITY_FACTOR = 0.5f; // Cue ball speed per unit of cue power - REDUCED by 50% to make shots slower
+
+// Ball structure
+struct Ball {
+    float x, y;           // Position
+    float vx, vy;         // Velocity
+    float radius;         // Radius
+    bool active;          // Is ball active (not pocketed)
+    int color[3];         // RGB color
+	int player;         // Player number (1 or 2)
+};
+
+// Pocket structure
+struct Pocket {
+    float x, y;           // Position
+    float radius;         // Radius
+};
+
+// Optional hook for analysis tools; normal play leaves GameState::observer null
+struct ShotObserver {
+    virtual ~ShotObserver() {}
+    virtual void cushionHit(const Ball& /*ball*/, float /*normalX*/, float /*normalY*/) {}
+    virtual void pocketed(int /*index*/, const Ball& /*ball*/) {}
+};
+
+// Physical constants, one block per table so they can be tuned together (game --calibrate)
+struct PhysicsParams {
+    // Velocity kept per step - INCREASED friction (was 0.992f)
+    float friction = 0.9992f;
+
+    // Per-axis speed below which a ball stops - INCREASED to stop balls sooner
+    float minVelocity = 0.00777f;
+
+    // Ball-ball restitution - REDUCED elasticity (was 0.9f)
+    float ballElasticity = 0.1f;
+
+    // Cushion restitution - REDUCED elasticity (was 0.9f)
+    float cushionRestitution = 0.8f;
+};
+
+// Game state
+struct GameState {
+    // Table properties
+    float tableWidth = 2.0f;
+    float tableHeight = 1.0f;
+    float cushionThickness = 0.05f;
+    float curveRadius = 0.1f; // Radius of the curved jaws near the corner pockets
+
+    // Balls
+    std::vector<Ball> balls;
+    int activeBalls = NUM_BALLS;
+
+    // Pockets
+    std::vector<Pocket> pockets;
+
+    // Cue properties
+    float cueAngle = 0.0f;
+    float cueLength = 0.5f;
+    float cuePower = 0.0f;
+    float maxCuePower = 0.05f;  // REDUCED maximum power (was 0.1f)
+    bool cueDragging = false;
+    bool cueAiming = true;
+
+    // Game state
+    bool ballsMoving = false;
+    int player1Score = 0;
+    int player2Score = 0;
+    int shots = 0;
+    bool gameOver = false;
+	int currentPlayer = 1; // Player 1 starts first
+    bool player1Solids = false;
+    bool player2Solids = false;
+	bool ballTypeAssigned = false; // Flag to check if ball type is assigned
+    bool potted = false;
+    bool foul = false;
+    unsigned pottedMask = 0; // Balls pocketed during the current shot (bit 0 = cue ball scratch)
+    int winner = -1;
+    std::string message = "";
+
+    PhysicsParams physics;
+
+    ShotObserver* observer = nullptr; // Not owned
+
+};
+
+// One recorded shot; a replay is the list of shots played from the opening rack
+struct ShotRecord {
+    float cueAngle;
+    float cuePower;
+};
+
+// Signed distance field of the playable outline: the felt, plus the pocket mouths cut into the
+// rails (corner mouths follow the jaw curves drawn in drawTable(), side mouths the pocket circles).
+// Positive inside the playable area, negative inside the cushions. Each sample also stores the
+// outward-from-cushion normal and the signed distance to the nearest pocket, so a ball needs one
+// bilinear lookup per step whatever the outline is made of.
+struct FieldSample {
+    float distance;       // To the cushion outline, > 0 on the playable side
+    float normalX;        // Direction of increasing distance
+    float normalY;
+    float pocketDistance; // To the nearest pocket edge, < 0 inside a pocket
+};
+
+struct Circle {
+    float x, y, radius;
+};
+
+struct Segment {
+    float x0, y0, x1, y1;
+};
+
+class TableField {
+public:
+    explicit TableField(const GameState& table, float cellSize = 0.01f) : cell(cellSize) {
+        left = -table.tableWidth / 2;
+        right = table.tableWidth / 2;
+        top = table.tableHeight / 2;
+        bottom = -table.tableHeight / 2;
+        for (const Pocket& pocket : table.pockets) {
+            pockets.push_back({ pocket.x, pocket.y, pocket.radius });
+            bool corner = std::fabs(std::fabs(pocket.x) - right) < 1e-4f && std::fabs(std::fabs(pocket.y) - top) < 1e-4f;
+            mouths.push_back({ pocket.x, pocket.y, corner ? table.curveRadius : pocket.radius });
+        }
+        addRail(left, top, right, top);
+        addRail(left, bottom, right, bottom);
+        addRail(left, bottom, left, top);
+        addRail(right, bottom, right, top);
+
+        float margin = table.curveRadius + 0.05f;
+        minX = left - margin;
+        minY = bottom - margin;
+        columns = (int)std::ceil((right - left + 2 * margin) / cell) + 1;
+        rows = (int)std::ceil((top - bottom + 2 * margin) / cell) + 1;
+        samples.resize((size_t)columns * rows);
+
+        const float h = cell * 0.05f;
+        for (int row = 0; row < rows; row++) {
+            for (int column = 0; column < columns; column++) {
+                float x = minX + column * cell;
+                float y = minY + row * cell;
+                FieldSample& sample = samples[(size_t)row * columns + column];
+                sample.distance = outlineDistance(x, y);
+                float gx = outlineDistance(x + h, y) - outlineDistance(x - h, y);
+                float gy = outlineDistance(x, y + h) - outlineDistance(x, y - h);
+                float length = std::sqrt(gx * gx + gy * gy);
+                sample.normalX = length > 0.0f ? gx / length : 0.0f;
+                sample.normalY = length > 0.0f ? gy / length : 0.0f;
+                sample.pocketDistance = nearestPocketDistance(x, y);
+            }
+        }
+    }
+
+    // Bilinear lookup; the normal is re-normalised after blending
+    FieldSample sample(float x, float y) const {
+        float fx = std::max(0.0f, std::min((x - minX) / cell, columns - 1.001f));
+        float fy = std::max(0.0f, std::min((y - minY) / cell, rows - 1.001f));
+        int column = (int)fx;
+        int row = (int)fy;
+        float tx = fx - column;
+        float ty = fy - row;
+
+        const FieldSample& a = samples[(size_t)row * columns + column];
+        const FieldSample& b = samples[(size_t)row * columns + column + 1];
+        const FieldSample& c = samples[(size_t)(row + 1) * columns + column];
+        const FieldSample& d = samples[(size_t)(row + 1) * columns + column + 1];
+        float wa = (1 - tx) * (1 - ty), wb = tx * (1 - ty), wc = (1 - tx) * ty, wd = tx * ty;
+
+        FieldSample result;
+        result.distance = a.distance * wa + b.distance * wb + c.distance * wc + d.distance * wd;
+        result.pocketDistance = a.pocketDistance * wa + b.pocketDistance * wb + c.pocketDistance * wc + d.pocketDistance * wd;
+        float nx = a.normalX * wa + b.normalX * wb + c.normalX * wc + d.normalX * wd;
+        float ny = a.normalY * wa + b.normalY * wb + c.normalY * wc + d.normalY * wd;
+        float length = std::sqrt(nx * nx + ny * ny);
+        result.normalX = length > 1e-6f ? nx / length : 0.0f;
+        result.normalY = length > 1e-6f ? ny / length : 0.0f;
+        return result;
+    }
+
+    // Exact signed distance to the outline (used to build the grid)
+    float outlineDistance(float x, float y) const {
+        float nearest = 1e9f;
+        for (const Segment& rail : rails) {
+            nearest = std::min(nearest, segmentDistance(rail, x, y));
+        }
+        // Mouth arcs only count where they run outside the felt; inside it they are open table
+        for (const Circle& mouth : mouths) {
+            float dx = x - mouth.x, dy = y - mouth.y;
+            float length = std::sqrt(dx * dx + dy * dy);
+            if (length < 1e-9f) {
+                nearest = std::min(nearest, mouth.radius);
+                continue;
+            }
+            float qx = mouth.x + dx / length * mouth.radius;
+            float qy = mouth.y + dy / length * mouth.radius;
+            if (!insideFelt(qx, qy)) nearest = std::min(nearest, std::fabs(length - mouth.radius));
+        }
+        return playable(x, y) ? nearest : -nearest;
+    }
+
+private:
+    bool insideFelt(float x, float y) const {
+        return x > left && x < right && y > bottom && y < top;
+    }
+
+    bool playable(float x, float y) const {
+        if (x >= left && x <= right && y >= bottom && y <= top) return true;
+        for (const Circle& mouth : mouths) {
+            float dx = x - mouth.x, dy = y - mouth.y;
+            if (dx * dx + dy * dy < mouth.radius * mouth.radius) return true;
+        }
+        return false;
+    }
+
+    float nearestPocketDistance(float x, float y) const {
+        float nearest = 1e9f;
+        for (const Circle& pocket : pockets) {
+            float dx = x - pocket.x, dy = y - pocket.y;
+            nearest = std::min(nearest, std::sqrt(dx * dx + dy * dy) - pocket.radius);
+        }
+        return nearest;
+    }
+
+    static float segmentDistance(const Segment& s, float x, float y) {
+        float ex = s.x1 - s.x0, ey = s.y1 - s.y0;
+        float t = ((x - s.x0) * ex + (y - s.y0) * ey) / (ex * ex + ey * ey);
+        t = std::max(0.0f, std::min(t, 1.0f));
+        float dx = x - (s.x0 + t * ex), dy = y - (s.y0 + t * ey);
+        return std::sqrt(dx * dx + dy * dy);
+    }
+
+    // Add an axis-aligned rail, minus the stretches the pocket mouths cut out of it
+    void addRail(float x0, float y0, float x1, float y1) {
+        bool horizontal = y0 == y1;
+        float start = horizontal ? x0 : y0;
+        float end = horizontal ? x1 : y1;
+
+        std::vector<std::pair<float, float>> gaps;
+        for (const Circle& mouth : mouths) {
+            float offset = horizontal ? mouth.y - y0 : mouth.x - x0;
+            if (std::fabs(offset) >= mouth.radius) continue;
+            float halfChord = std::sqrt(mouth.radius * mouth.radius - offset * offset);
+            float centre = horizontal ? mouth.x : mouth.y;
+            gaps.push_back({ centre - halfChord, centre + halfChord });
+        }
+        std::sort(gaps.begin(), gaps.end());
+
+        float cursor = start;
+        for (const std::pair<float, float>& gap : gaps) {
+            if (gap.first > cursor) pushRail(horizontal, y0, x0, cursor, std::min(gap.first, end));
+            cursor = std::max(cursor, gap.second);
+        }
+        if (cursor < end) pushRail(horizontal, y0, x0, cursor, end);
+    }
+
+    void pushRail(bool horizontal, float y, float x, float from, float to) {
+        if (to <= from) return;
+        if (horizontal) rails.push_back({ from, y, to, y });
+        else rails.push_back({ x, from, x, to });
+    }
+
+    float left, right, top, bottom;
+    std::vector<Circle> pockets;
+    std::vector<Circle> mouths;
+    std::vector<Segment> rails;
+
+    float cell;
+    float minX, minY;
+    int columns, rows;
+    std::vector<FieldSample> samples;
+};
+
+// All tables share one geometry, so the field is built once on first use
+const TableField& tableField();
+
+void initializePockets(GameState& g);
+void initializeGame(GameState& g);
+void switchPlayer(GameState& g);
+void assignBallOwners(GameState& g);
+
+// Collisions, cushions and pockets for one step
+bool resolveBallPair(Ball& a, Ball& b, float elasticity);
+void handleBallCollisionsScalar(GameState& g);
+void handleBallCollisions(GameState& g);
+void handleCushionsAndPockets(GameState& g, uint32_t mask = ~0u);
+bool allBallsStopped(GameState& g);
+extern const bool cpuHasAvx2; // Picks the contact kernel handleBallCollisions() runs
+
+void applyShot(GameState& g, float cueAngle, float cuePower);
+void integrateBall(const GameState& g, Ball& ball);
+void advanceBalls(GameState& g);
+void finishShot(GameState& g);
+void update(GameState& g);
+int simulateToRest(GameState& g, int maxSteps);
+float scoreShotOutcome(const GameState& before, const GameState& after);
@@ -0,0 +1,428 @@
+#include "search.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Brute-force search over a spread of angles and powers (kept as the --bench-aim baseline)
+ShotRecord chooseShotBySampling(const GameState& table) {
+    const int angleSteps = 72;
+    const int powerSteps = 4;
+    ShotRecord best = { 0.0f, table.maxCuePower };
+    float bestScore = -1e9f;
+
+    GameState trial;
+    for (int a = 0; a < angleSteps; a++) {
+        for (int p = 1; p <= powerSteps; p++) {
+            trial = table;
+            float angle = a * 2.0f * PI / angleSteps;
+            float power = table.maxCuePower * p / powerSteps;
+            applyShot(trial, angle, power);
+            simulateToRest(trial, MAX_SHOT_STEPS);
+            float score = scoreShotOutcome(table, trial);
+            if (score > bestScore) {
+                bestScore = score;
+                best = { angle, power };
+            }
+        }
+    }
+    return best;
+}
+
+// Coarse shot simulation, for ranking many candidate shots before simulating a few properly.
+// Same integrator, cushions and pockets as update(), with three shortcuts:
+//  - while balls are slow, several integration steps run between collision passes, as many as
+//    keeps every ball within a radius of travel per pass (COARSE_MAX_SUBSTEPS at most);
+//  - ball-ball contacts are only tested for pairs with a moving ball, in any order;
+//  - it stops once no moving ball can reach a pocket or another ball before friction stops it,
+//    because nothing after that changes how the shot scores.
+// There is no useful bound on how far its final positions are from update()'s: one contact
+// found late or missed can send a ball anywhere on the table. --bench-coarse measures the gap
+// and how often the two tiers disagree on the outcome.
+const int COARSE_MAX_SUBSTEPS = 8;
+const int COARSE_DECIDED_CHECK = 8; // Coarse steps between early-stop checks
+const float COARSE_FIELD_SLACK = 0.01f; // One field cell, for interpolated pocket distances
+
+// Upper bound on the path a ball still rolls with nothing in its way, per-axis cut-off included
+float remainingRoll(const GameState& g, const Ball& ball) {
+    float friction = g.physics.friction;
+    float cutoff = friction * g.physics.minVelocity;
+    float rollX = fabs(ball.vx) + std::max(0.0f, (float)fabs(ball.vx) - cutoff) / (1.0f - friction);
+    float rollY = fabs(ball.vy) + std::max(0.0f, (float)fabs(ball.vy) - cutoff) / (1.0f - friction);
+    return rollX + rollY;
+}
+
+// Can anything still be pocketed or hit?
+bool outcomeOpen(const GameState& g) {
+    const TableField& field = tableField();
+    float roll[NUM_BALLS] = {};
+    for (size_t i = 0; i < g.balls.size(); i++) {
+        const Ball& ball = g.balls[i];
+        if (!ball.active || (ball.vx == 0.0f && ball.vy == 0.0f)) continue;
+        roll[i] = remainingRoll(g, ball);
+        if (field.sample(ball.x, ball.y).pocketDistance < roll[i] + COARSE_FIELD_SLACK) return true;
+    }
+    for (size_t i = 0; i < g.balls.size(); i++) {
+        if (roll[i] == 0.0f) continue;
+        for (size_t j = 0; j < g.balls.size(); j++) {
+            if (j == i || !g.balls[j].active) continue;
+            float dx = g.balls[j].x - g.balls[i].x, dy = g.balls[j].y - g.balls[i].y;
+            float reach = g.balls[i].radius + g.balls[j].radius + roll[i] + roll[j];
+            if (dx * dx + dy * dy < reach * reach) return true;
+        }
+    }
+    return false;
+}
+
+// Coarse counterpart of simulateToRest(); leaves the turn finished as update() would
+CoarseResult simulateCoarse(GameState& g, int maxSteps) {
+    CoarseResult result;
+    for (int pass = 0; g.ballsMoving && !g.gameOver && result.steps < maxSteps; pass++) {
+        float fastest = 0.0f;
+        uint32_t moving = 0;
+        for (size_t i = 0; i < g.balls.size(); i++) {
+            const Ball& ball = g.balls[i];
+            if (!ball.active || (ball.vx == 0.0f && ball.vy == 0.0f)) continue;
+            moving |= 1u << i;
+            fastest = std::max(fastest, (float)(fabs(ball.vx) + fabs(ball.vy)));
+        }
+        int substeps = fastest > 0.0f ? (int)(g.balls[0].radius / fastest) : COARSE_MAX_SUBSTEPS;
+        substeps = std::max(1, std::min(substeps, COARSE_MAX_SUBSTEPS));
+
+        for (size_t i = 0; i < g.balls.size(); i++) {
+            if (!(moving & (1u << i))) continue;
+            for (int s = 0; s < substeps; s++) integrateBall(g, g.balls[i]);
+        }
+        result.steps += substeps;
+        result.passes++;
+
+        uint32_t touched = moving;
+        for (size_t i = 0; i < g.balls.size(); i++) {
+            if (!(moving & (1u << i))) continue;
+            for (size_t j = 0; j < g.balls.size(); j++) {
+                if (j == i || !g.balls[j].active || ((moving & (1u << j)) && j < i)) continue;
+                Ball& a = g.balls[i];
+                Ball& b = g.balls[j];
+                if (resolveBallPair(a, b, g.physics.ballElasticity)) touched |= 1u << j;
+            }
+        }
+        // Balls that neither moved nor were hit can't reach a cushion or a pocket
+        handleCushionsAndPockets(g, touched);
+
+        if (allBallsStopped(g)) finishShot(g);
+        else if (pass % COARSE_DECIDED_CHECK == COARSE_DECIDED_CHECK - 1 && !outcomeOpen(g)) finishShot(g);
+    }
+    return result;
+}
+
+struct RankedShot {
+    ShotRecord shot;
+    float score;
+};
+
+// Blind search over a fine spread of angles and powers: every candidate simulated coarsely,
+// then only the precise best of them re-run through update() to pick the shot
+ShotRecord chooseShotByCoarseRanking(const GameState& table, int angleSteps, int powerSteps, size_t precise) {
+    std::vector<RankedShot> ranked;
+    ranked.reserve((size_t)angleSteps * powerSteps);
+    GameState trial;
+    for (int a = 0; a < angleSteps; a++) {
+        for (int p = 1; p <= powerSteps; p++) {
+            trial = table;
+            ShotRecord shot = { a * 2.0f * PI / angleSteps, table.maxCuePower * p / powerSteps };
+            applyShot(trial, shot.cueAngle, shot.cuePower);
+            simulateCoarse(trial, MAX_SHOT_STEPS);
+            ranked.push_back({ shot, scoreShotOutcome(table, trial) });
+        }
+    }
+
+    // Best score first; among equals, the earlier candidate
+    size_t keep = std::min(precise, ranked.size());
+    std::stable_sort(ranked.begin(), ranked.end(), [](const RankedShot& a, const RankedShot& b) { return a.score > b.score; });
+
+    ShotRecord best = ranked.empty() ? ShotRecord{ 0.0f, table.maxCuePower } : ranked[0].shot;
+    float bestScore = -1e9f;
+    for (size_t i = 0; i < keep; i++) {
+        trial = table;
+        applyShot(trial, ranked[i].shot.cueAngle, ranked[i].shot.cuePower);
+        simulateToRest(trial, MAX_SHOT_STEPS);
+        float score = scoreShotOutcome(table, trial);
+        if (score > bestScore) {
+            bestScore = score;
+            best = ranked[i].shot;
+        }
+    }
+    return best;
+}
+
+// Ghost-ball aim solver. For every (object ball, pocket) pair the cue ball must arrive at the
+// "ghost" spot one ball-width behind the object ball on the pocket line. Pairs with too thin a
+// cut or a blocked path are dropped on geometry alone. For the rest the power comes in closed
+// form from friction and minVelocity (see rolledDistance()), working back from the speed the
+// object ball needs to reach the pocket to the speed the cue ball needs at contact; one
+// closed-form check of the contact and the object ball's roll then confirms the pot. Nothing is
+// stepped through, and the computer player nearly always simulates just the shot it plays.
+
+// Would a ball of the given radius moving from (x0, y0) to (x1, y1) touch any other active ball?
+bool pathBlocked(const GameState& g, float x0, float y0, float x1, float y1, float radius, int skipA, int skipB) {
+    float ex = x1 - x0, ey = y1 - y0;
+    float lengthSq = ex * ex + ey * ey;
+    for (int k = 0; k < (int)g.balls.size(); k++) {
+        const Ball& other = g.balls[k];
+        if (k == skipA || k == skipB || !other.active) continue;
+        float t = lengthSq > 0.0f ? ((other.x - x0) * ex + (other.y - y0) * ey) / lengthSq : 0.0f;
+        t = std::max(0.0f, std::min(t, 1.0f));
+        float dx = other.x - (x0 + t * ex), dy = other.y - (y0 + t * ey);
+        float reach = radius + other.radius;
+        if (dx * dx + dy * dy < reach * reach) return true;
+    }
+    return false;
+}
+
+// A ball rolling alone, in closed form. integrateBall() moves each axis by its velocity, then
+// multiplies the velocity by friction and zeroes it once it is under minVelocity. So an axis
+// starting at speed u moves u (1 - f^n) / (1 - f) over its first n steps, stops after
+// stepsToStop(u) of them, and rolls further than (u - minVelocity) / (1 - f) in all. Each axis
+// stops on its own: the path is straight until the slower axis stops, then runs along the other.
+const float AIM_POWER_MARGIN = 1.05f; // Over the softest power the closed form allows
+const int AIM_SPEED_BISECTIONS = 12;
+
+// Steps an axis starting at the given speed moves before the cut-off zeroes it
+int stepsToStop(const PhysicsParams& physics, float speed) {
+    if (speed < physics.minVelocity) return 1;
+    return (int)floor(log(physics.minVelocity / speed) / log(physics.friction)) + 1;
+}
+
+// Distance an axis starting at the given speed covers in its first steps (while still moving)
+float rolledDistance(const PhysicsParams& physics, float speed, int steps) {
+    return speed * (1.0f - (float)pow((double)physics.friction, steps)) / (1.0f - physics.friction);
+}
+
+// Speed an axis must start at to roll at least the given distance before it stops
+float speedToRoll(const PhysicsParams& physics, float distance) {
+    return distance * (1.0f - physics.friction) + physics.minVelocity;
+}
+
+float segmentDistance(float px, float py, float x0, float y0, float x1, float y1) {
+    float ex = x1 - x0, ey = y1 - y0;
+    float lengthSq = ex * ex + ey * ey;
+    float t = lengthSq > 0.0f ? std::max(0.0f, std::min(((px - x0) * ex + (py - y0) * ey) / lengthSq, 1.0f)) : 0.0f;
+    return std::hypot(px - (x0 + t * ex), py - (y0 + t * ey));
+}
+
+// Does a ball rolling alone from (x, y) at (vx, vy) pass over the pocket before it stops?
+bool rollsIntoPocket(const PhysicsParams& physics, float x, float y, float vx, float vy, const Pocket& pocket) {
+    int stopX = vx != 0.0f ? stepsToStop(physics, fabs(vx)) : 0;
+    int stopY = vy != 0.0f ? stepsToStop(physics, fabs(vy)) : 0;
+    int bend = std::min(stopX, stopY);
+    float bendX = x + std::copysign(rolledDistance(physics, fabs(vx), std::min(bend, stopX)), vx);
+    float bendY = y + std::copysign(rolledDistance(physics, fabs(vy), std::min(bend, stopY)), vy);
+    float endX = x + std::copysign(rolledDistance(physics, fabs(vx), stopX), vx);
+    float endY = y + std::copysign(rolledDistance(physics, fabs(vy), stopY), vy);
+    return segmentDistance(pocket.x, pocket.y, x, y, bendX, bendY) < pocket.radius ||
+           segmentDistance(pocket.x, pocket.y, bendX, bendY, endX, endY) < pocket.radius;
+}
+
+// Steps until an axis starting at the given speed has rolled further than distance; past its
+// stepsToStop() if it never does
+int stepsToRoll(const PhysicsParams& physics, float speed, float distance) {
+    if (distance <= 0.0f) return 1;
+    float left = 1.0f - distance * (1.0f - physics.friction) / speed;
+    if (left <= 0.0f) return stepsToStop(physics, speed) + 1;
+    return (int)floor(log(left) / log(physics.friction)) + 1;
+}
+
+// The step on which the cue ball, shot along the unit vector (dx, dy) at the given speed, first
+// overlaps the object ball, as handleBallCollisions() finds it, on its path bent by whichever
+// axis stops first: where its centre is then and its velocity. False if it stops short.
+bool cueContact(const PhysicsParams& physics, const Ball& cue, const Ball& object, float dx, float dy, float speed,
+                float& contactX, float& contactY, float& contactVx, float& contactVy) {
+    float reach = cue.radius + object.radius;
+    float speedX = std::fabs(dx) * speed, speedY = std::fabs(dy) * speed;
+    int stopX = speedX > 0.0f ? stepsToStop(physics, speedX) : 0;
+    int stopY = speedY > 0.0f ? stepsToStop(physics, speedY) : 0;
+    int bend = std::min(stopX, stopY);
+
+    // Along the shot line while both axes roll
+    float wx = object.x - cue.x, wy = object.y - cue.y;
+    float along = wx * dx + wy * dy;
+    float missSq = reach * reach - (wx * wx + wy * wy - along * along);
+    int steps = 0;
+    if (along > 0.0f && missSq > 0.0f) {
+        float touch = along - sqrt(missSq);
+        if (touch <= 0.0f) return false;
+        steps = stepsToRoll(physics, speed, touch);
+    }
+    if (steps == 0 || steps > bend) {
+        // Then along the axis still rolling, from the bend
+        bool alongX = stopX > stopY;
+        float bendX = cue.x + std::copysign(rolledDistance(physics, speedX, std::min(bend, stopX)), dx);
+        float bendY = cue.y + std::copysign(rolledDistance(physics, speedY, std::min(bend, stopY)), dy);
+        float gap = alongX ? object.x - bendX : object.y - bendY;
+        float side = alongX ? object.y - bendY : object.x - bendX;
+        float heading = alongX ? dx : dy;
+        float axisSpeed = alongX ? speedX : speedY;
+        if (reach * reach <= side * side || gap * heading <= 0.0f) return false;
+        float touch = rolledDistance(physics, axisSpeed, bend) + std::fabs(gap) - sqrt(reach * reach - side * side);
+        steps = std::max(stepsToRoll(physics, axisSpeed, touch), bend + 1);
+        if (steps > (alongX ? stopX : stopY)) return false;
+    }
+
+    float rolledX = rolledDistance(physics, speedX, std::min(steps, stopX));
+    float rolledY = rolledDistance(physics, speedY, std::min(steps, stopY));
+    float decay = (float)pow((double)physics.friction, steps);
+    contactX = cue.x + std::copysign(rolledX, dx);
+    contactY = cue.y + std::copysign(rolledY, dy);
+    contactVx = steps < stopX ? dx * speed * decay : 0.0f;
+    contactVy = steps < stopY ? dy * speed * decay : 0.0f;
+    return true;
+}
+
+// Softest speed that rolls a ball from (x, y) along the unit vector (nx, ny) into the pocket, or
+// 0 if even the fastest does not. More speed only moves the bend further along, so bisect.
+float speedToPocket(const PhysicsParams& physics, float x, float y, float nx, float ny, float fastest, const Pocket& pocket) {
+    if (!rollsIntoPocket(physics, x, y, nx * fastest, ny * fastest, pocket)) return 0.0f;
+    float low = 0.0f, high = fastest;
+    for (int i = 0; i < AIM_SPEED_BISECTIONS; i++) {
+        float middle = (low + high) / 2.0f;
+        if (rollsIntoPocket(physics, x, y, nx * middle, ny * middle, pocket)) high = middle;
+        else low = middle;
+    }
+    return high;
+}
+
+// Cue speed that arrives at contactDistance, along the unit vector (dx, dy), fast enough to give
+// the object ball objectSpeed at cosCut to the shot: resolveBallPair() gives it (1 + elasticity)
+// times the cue ball's normal speed, and rolling a unit of distance costs (1 - f) of speed, plus
+// up to a step of overshoot. If the maximum allows, also fast enough for both axes to roll all
+// the way, so the cue ball gets there on the straight line.
+float cueSpeedFor(const PhysicsParams& physics, float dx, float dy, float cosCut, float contactDistance, float objectSpeed,
+                  float fastest) {
+    float contactSpeed = objectSpeed / ((1.0f + physics.ballElasticity) * cosCut);
+    float speed = (contactSpeed + contactDistance * (1.0f - physics.friction)) / physics.friction * AIM_POWER_MARGIN;
+    float straight = speed;
+    float direction[2] = { dx, dy };
+    for (float axis : direction) {
+        float share = std::fabs(axis);
+        if (share > 0.0f) straight = std::max(straight, speedToRoll(physics, share * contactDistance) / share * AIM_POWER_MARGIN);
+    }
+    return straight <= fastest ? straight : speed;
+}
+
+// Balls the shooter may legally aim at
+bool isTargetBall(const GameState& g, int index) {
+    if (index == 0 || !g.balls[index].active) return false;
+    bool ownBallsLeft = false;
+    for (int k = 1; k < (int)g.balls.size(); k++) {
+        if (k == 8 || !g.balls[k].active) continue;
+        if (!g.ballTypeAssigned || g.balls[k].player == g.currentPlayer) ownBallsLeft = true;
+    }
+    if (index == 8) return !ownBallsLeft;
+    return !g.ballTypeAssigned || g.balls[index].player == g.currentPlayer;
+}
+
+std::vector<AimCandidate> findGhostBallShots(const GameState& g) {
+    const float maxCut = 85.0f * PI / 180.0f;
+
+    std::vector<AimCandidate> candidates;
+    const Ball& cue = g.balls[0];
+    if (!cue.active) return candidates;
+
+    for (int b = 1; b < (int)g.balls.size(); b++) {
+        if (!isTargetBall(g, b)) continue;
+        const Ball& object = g.balls[b];
+
+        for (int p = 0; p < (int)g.pockets.size(); p++) {
+            const Pocket& pocket = g.pockets[p];
+            float ox = pocket.x - object.x, oy = pocket.y - object.y;
+            float objectDistance = sqrt(ox * ox + oy * oy);
+            if (objectDistance < 1e-6f) continue;
+            ox /= objectDistance;
+            oy /= objectDistance;
+
+            // Ghost ball: where the cue ball centre must be at contact
+            float ghostX = object.x - ox * (cue.radius + object.radius);
+            float ghostY = object.y - oy * (cue.radius + object.radius);
+            float cx = ghostX - cue.x, cy = ghostY - cue.y;
+            float cueDistance = sqrt(cx * cx + cy * cy);
+            if (cueDistance < 1e-6f) continue;
+
+            float cosCut = (cx * ox + cy * oy) / cueDistance;
+            if (cosCut < cos(maxCut)) continue;
+            if (pathBlocked(g, cue.x, cue.y, ghostX, ghostY, cue.radius, 0, b)) continue;
+            if (pathBlocked(g, object.x, object.y, pocket.x, pocket.y, object.radius, 0, b)) continue;
+
+            // Softest the object ball can go and still drop, on its bent closed-form path
+            float fastest = (1.0f + g.physics.ballElasticity) * g.maxCuePower * SHOT_VELOCITY_FACTOR;
+            float objectSpeed = speedToPocket(g.physics, object.x, object.y, ox, oy, fastest, pocket) * AIM_POWER_MARGIN;
+            if (objectSpeed == 0.0f) continue;
+
+            // Contact is only detected once the balls overlap, up to a whole step late, so slide
+            // the ghost ball to where the cue ball actually is at that step and aim again
+            float aimX = ghostX, aimY = ghostY, power = 0.0f;
+            float contactX = 0.0f, contactY = 0.0f, contactVx = 0.0f, contactVy = 0.0f;
+            bool reached = false;
+            for (int pass = 0; pass < 3; pass++) {
+                float ax = aimX - cue.x, ay = aimY - cue.y;
+                float aimDistance = sqrt(ax * ax + ay * ay);
+                ax /= aimDistance;
+                ay /= aimDistance;
+                power = cueSpeedFor(g.physics, ax, ay, ax * ox + ay * oy, aimDistance, objectSpeed, g.maxCuePower * SHOT_VELOCITY_FACTOR) /
+                        SHOT_VELOCITY_FACTOR;
+                reached = power <= g.maxCuePower &&
+                          cueContact(g.physics, cue, object, ax, ay, power * SHOT_VELOCITY_FACTOR, contactX, contactY, contactVx, contactVy);
+                if (!reached) break;
+                float hx = object.x - contactX, hy = object.y - contactY;
+                float depth = sqrt(hx * hx + hy * hy);
+                if (fabs(hx / depth - ox) + fabs(hy / depth - oy) < 1e-4f) break;
+                aimX = object.x - ox * depth;
+                aimY = object.y - oy * depth;
+            }
+            if (!reached) continue;
+
+            // The one check: the impulse and separation resolveBallPair() applies, then the roll
+            float hx = object.x - contactX, hy = object.y - contactY;
+            float depth = sqrt(hx * hx + hy * hy);
+            float nx = hx / depth, ny = hy / depth;
+            float impulse = (1.0f + g.physics.ballElasticity) * (contactVx * nx + contactVy * ny);
+            float separation = (cue.radius + object.radius - depth) / 2.0f;
+            if (impulse <= 0.0f ||
+                !rollsIntoPocket(g.physics, object.x + nx * separation, object.y + ny * separation, nx * impulse, ny * impulse, pocket)) {
+                continue;
+            }
+
+            AimCandidate candidate;
+            candidate.ball = b;
+            candidate.pocket = p;
+            candidate.cueAngle = atan2(aimY - cue.y, aimX - cue.x) + PI;
+            candidate.cuePower = power;
+            candidate.ghostX = aimX;
+            candidate.ghostY = aimY;
+            candidate.difficulty = (1.0f - cosCut) * 4.0f + cueDistance + objectDistance + power / g.maxCuePower;
+            candidates.push_back(candidate);
+        }
+    }
+
+    std::sort(candidates.begin(), candidates.end(),
+              [](const AimCandidate& a, const AimCandidate& b) { return a.difficulty < b.difficulty; });
+    return candidates;
+}
+
+// Computer player: rank ghost-ball shots geometrically and play the easiest one that a full
+// simulation confirms scores; the closed form makes that nearly always the first. Falls back to
+// a coarse-ranked blind search when nothing pots cleanly (tight clusters, every path blocked).
+ShotRecord chooseComputerShot(const GameState& table) {
+    const size_t confirmCount = 4;
+    std::vector<AimCandidate> candidates = findGhostBallShots(table);
+
+    GameState trial;
+    for (size_t i = 0; i < candidates.size() && i < confirmCount; i++) {
+        ShotRecord shot = { candidates[i].cueAngle, candidates[i].cuePower };
+        trial = table;
+        applyShot(trial, shot.cueAngle, shot.cuePower);
+        simulateToRest(trial, MAX_SHOT_STEPS);
+        if (scoreShotOutcome(table, trial) > 0.0f) return shot;
+    }
+    return chooseShotByCoarseRanking(table);
+}
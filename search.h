@@ -0,0 +1,29 @@
+// Shot search for the computer player and the aim hints
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "physics.h"
+
+// A shot that pots one object ball in one pocket, straight off the cue ball
+struct AimCandidate {
+    int ball;
+    int pocket;
+    float cueAngle;   // As stored in GameState (shot direction + PI)
+    float cuePower;
+    float ghostX, ghostY;
+    float difficulty; // Lower is easier
+};
+
+// Work simulateCoarse() did, for comparing it with simulateToRest()
+struct CoarseResult {
+    int steps = 0; // Integration steps, comparable with simulateToRest()
+    int passes = 0; // Collision, cushion and pocket passes
+};
+
+ShotRecord chooseShotBySampling(const GameState& table);
+CoarseResult simulateCoarse(GameState& g, int maxSteps);
+ShotRecord chooseShotByCoarseRanking(const GameState& table, int angleSteps = 360, int powerSteps = 6, size_t precise = 8);
+std::vector<AimCandidate> findGhostBallShots(const GameState& g);
+ShotRecord chooseComputerShot(const GameState& table);
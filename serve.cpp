@@ -0,0 +1,572 @@
+#include "tools.h"
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <poll.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Batch shot evaluation service (game --serve)
+//
+// Reads shot queries from stdin and writes one result per query to stdout, in input order.
+// NDJSON (default), one object per line:
+//   {"id":7,"angle":3.14,"power":0.04,"player":1,"assigned":true,"player1Solids":false,
+//    "balls":[[-0.4,0.0],[0.4,0.0],null,...]}
+// "angle"/"power" are cueAngle/cuePower as set while aiming. "balls" (16 entries, null = pocketed)
+// and the ball type fields are optional; missing balls mean the opening rack. Balls must lie on
+// the cloth without overlapping; a query that breaks this gets an "error" result instead.
+// Binary (--binary): little-endian frames, each a uint32 payload length followed by the payload
+// laid out as in readBinaryRequest()/appendBinaryResult().
+
+const size_t SHOT_CHUNK = 8;           // Shots a worker claims at a time
+const uint32_t MAX_FRAME_SIZE = 1 << 20;
+const size_t BINARY_REQUEST_SIZE = 150;
+const float REQUEST_OVERLAP_SLACK = 1e-4f; // Touching balls written with rounding still pass
+
+struct ShotRequest {
+    uint64_t id = 0;
+    float cueAngle = 0.0f;
+    float cuePower = 0.0f;
+    int currentPlayer = 1;
+    bool ballTypeAssigned = false;
+    bool player1Solids = false;
+    bool hasPositions = false; // Otherwise the opening rack is used
+    float x[NUM_BALLS] = {};
+    float y[NUM_BALLS] = {};
+    bool active[NUM_BALLS] = {};
+    std::string error;         // Set when the query could not be parsed
+};
+
+struct ShotResult {
+    uint64_t id = 0;
+    int steps = 0;
+    bool settled = false;      // False if MAX_SHOT_STEPS was hit first
+    unsigned pottedMask = 0;
+    bool gameOver = false;
+    int winner = -1;
+    int nextPlayer = 1;
+    float x[NUM_BALLS] = {};
+    float y[NUM_BALLS] = {};
+    bool active[NUM_BALLS] = {};
+    std::string error;
+};
+
+// Why a parsed query cannot be simulated, or null if it can
+const char* invalidRequest(const ShotRequest& request, const GameState& rack) {
+    if (request.currentPlayer != 1 && request.currentPlayer != 2) return "player must be 1 or 2";
+    if (!std::isfinite(request.cueAngle) || !std::isfinite(request.cuePower)) return "angle and power must be finite";
+    if (!request.hasPositions) return nullptr;
+    if (!request.active[0]) return "cue ball must be on the table";
+    for (int i = 0; i < NUM_BALLS; i++) {
+        if (!request.active[i]) continue;
+        float radius = rack.balls[i].radius;
+        if (!std::isfinite(request.x[i]) || !std::isfinite(request.y[i]) || fabs(request.x[i]) > rack.tableWidth / 2 - radius ||
+            fabs(request.y[i]) > rack.tableHeight / 2 - radius) {
+            return "balls must lie on the cloth";
+        }
+        for (int j = 0; j < i; j++) {
+            if (!request.active[j]) continue;
+            float dx = request.x[i] - request.x[j], dy = request.y[i] - request.y[j];
+            float reach = radius + rack.balls[j].radius - REQUEST_OVERLAP_SLACK;
+            if (dx * dx + dy * dy < reach * reach) return "balls must not overlap";
+        }
+    }
+    return nullptr;
+}
+
+// Load a query into a reusable GameState and run the shot to rest with update()
+void evaluateShot(const ShotRequest& request, const GameState& rack, GameState& g, ShotResult& result) {
+    result.id = request.id;
+    result.error = request.error;
+    if (result.error.empty()) {
+        if (const char* invalid = invalidRequest(request, rack)) result.error = invalid;
+    }
+    if (!result.error.empty()) return;
+
+    g = rack; // Reuses g's buffers, so no allocation once warmed up
+    g.currentPlayer = request.currentPlayer;
+    if (request.ballTypeAssigned) {
+        g.ballTypeAssigned = true;
+        g.player1Solids = request.player1Solids;
+        g.player2Solids = !request.player1Solids;
+        assignBallOwners(g);
+    }
+    if (request.hasPositions) {
+        g.activeBalls = 0;
+        for (int i = 0; i < NUM_BALLS; i++) {
+            g.balls[i].x = request.x[i];
+            g.balls[i].y = request.y[i];
+            g.balls[i].active = request.active[i];
+            if (g.balls[i].active) g.activeBalls++;
+        }
+    }
+
+    applyShot(g, request.cueAngle, request.cuePower);
+    result.steps = simulateToRest(g, MAX_SHOT_STEPS);
+    result.settled = !g.ballsMoving;
+    result.pottedMask = g.pottedMask;
+    result.gameOver = g.gameOver;
+    result.winner = g.winner;
+    result.nextPlayer = g.currentPlayer;
+    for (int i = 0; i < NUM_BALLS; i++) {
+        result.x[i] = g.balls[i].x;
+        result.y[i] = g.balls[i].y;
+        result.active[i] = g.balls[i].active;
+    }
+}
+
+// Minimal JSON scanner for the flat query objects above
+class JsonCursor {
+public:
+    JsonCursor(const char* begin, const char* end) : p(begin), end(end) {}
+
+    bool consume(char c) {
+        skipSpace();
+        if (p < end && *p == c) {
+            p++;
+            return true;
+        }
+        return false;
+    }
+
+    bool readString(std::string& out) {
+        if (!consume('"')) return false;
+        out.clear();
+        while (p < end && *p != '"') {
+            if (*p == '\\' && p + 1 < end) p++;
+            out += *p++;
+        }
+        return consume('"');
+    }
+
+    bool readNumber(double& out) {
+        skipSpace();
+        char* stop = nullptr;
+        out = strtod(p, &stop); // The line buffer is NUL terminated
+        if (stop == p || stop > end || !std::isfinite(out)) return false; // JSON has no nan or inf
+        p = stop;
+        return true;
+    }
+
+    bool readUnsigned(uint64_t& out) {
+        skipSpace();
+        char* stop = nullptr;
+        out = strtoull(p, &stop, 10);
+        if (stop == p || stop > end) return false;
+        p = stop;
+        return true;
+    }
+
+    bool readBool(bool& out) {
+        if (readLiteral("true")) out = true;
+        else if (readLiteral("false")) out = false;
+        else {
+            double number;
+            if (!readNumber(number)) return false;
+            out = number != 0.0;
+        }
+        return true;
+    }
+
+    bool readLiteral(const char* literal) {
+        skipSpace();
+        size_t length = strlen(literal);
+        if ((size_t)(end - p) < length || strncmp(p, literal, length) != 0) return false;
+        p += length;
+        return true;
+    }
+
+    // Skip a value of any type (for keys we do not use)
+    bool skipValue() {
+        skipSpace();
+        if (p >= end) return false;
+        if (*p == '"') {
+            std::string ignored;
+            return readString(ignored);
+        }
+        if (*p == '[' || *p == '{') {
+            int depth = 0;
+            bool inString = false;
+            for (; p < end; p++) {
+                if (inString) {
+                    if (*p == '\\') p++;
+                    else if (*p == '"') inString = false;
+                }
+                else if (*p == '"') inString = true;
+                else if (*p == '[' || *p == '{') depth++;
+                else if ((*p == ']' || *p == '}') && --depth == 0) {
+                    p++;
+                    return true;
+                }
+            }
+            return false;
+        }
+        if (readLiteral("true") || readLiteral("false") || readLiteral("null")) return true;
+        double ignored;
+        return readNumber(ignored);
+    }
+
+    bool atEnd() {
+        skipSpace();
+        return p == end;
+    }
+
+private:
+    void skipSpace() {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) p++;
+    }
+
+    const char* p;
+    const char* end;
+};
+
+bool parseBallList(JsonCursor& json, ShotRequest& request) {
+    if (!json.consume('[')) return false;
+    for (int i = 0; i < NUM_BALLS; i++) {
+        if (i > 0 && !json.consume(',')) return false;
+        if (json.readLiteral("null")) {
+            request.active[i] = false;
+            continue;
+        }
+        double x, y;
+        if (!json.consume('[') || !json.readNumber(x) || !json.consume(',') || !json.readNumber(y) || !json.consume(']')) {
+            return false;
+        }
+        request.x[i] = (float)x;
+        request.y[i] = (float)y;
+        request.active[i] = true;
+    }
+    request.hasPositions = true;
+    return json.consume(']');
+}
+
+void parseJsonRequest(const std::string& line, ShotRequest& request) {
+    request = ShotRequest();
+    JsonCursor json(line.data(), line.data() + line.size());
+    std::string key;
+    bool ok = json.consume('{');
+    bool first = true;
+    while (ok && !json.consume('}')) {
+        if (!first && !json.consume(',')) {
+            ok = false;
+            break;
+        }
+        first = false;
+        if (!json.readString(key) || !json.consume(':')) {
+            ok = false;
+            break;
+        }
+
+        double number = 0.0;
+        if (key == "angle" || key == "power" || key == "player") {
+            ok = json.readNumber(number);
+            if (key == "angle") request.cueAngle = (float)number;
+            else if (key == "power") request.cuePower = (float)number;
+            else request.currentPlayer = (int)number;
+        }
+        else if (key == "id") ok = json.readUnsigned(request.id);
+        else if (key == "assigned") ok = json.readBool(request.ballTypeAssigned);
+        else if (key == "player1Solids") ok = json.readBool(request.player1Solids);
+        else if (key == "balls") ok = parseBallList(json, request);
+        else ok = json.skipValue();
+    }
+
+    if (!ok || !json.atEnd()) request.error = "malformed request";
+}
+
+void appendJsonResult(std::string& out, const ShotResult& result) {
+    char buffer[96];
+    snprintf(buffer, sizeof(buffer), "{\"id\":%llu", (unsigned long long)result.id);
+    out += buffer;
+
+    // JSON has no nan or inf, so a result holding one goes out as an error, never as a number
+    bool finite = true;
+    for (int i = 0; i < NUM_BALLS; i++) {
+        if (result.active[i]) finite &= std::isfinite(result.x[i]) && std::isfinite(result.y[i]);
+    }
+    if (!result.error.empty() || !finite) {
+        out += ",\"error\":\"" + (result.error.empty() ? std::string("simulation diverged") : result.error) + "\"}\n";
+        return;
+    }
+
+    snprintf(buffer, sizeof(buffer), ",\"steps\":%d,\"settled\":%s,\"potted\":[", result.steps, result.settled ? "true" : "false");
+    out += buffer;
+    bool first = true;
+    for (int i = 0; i < NUM_BALLS; i++) {
+        if (!(result.pottedMask & (1u << i))) continue;
+        if (!first) out += ',';
+        out += std::to_string(i);
+        first = false;
+    }
+    snprintf(buffer, sizeof(buffer), "],\"foul\":%s,\"player\":%d,\"gameOver\":%s,\"winner\":%d,\"balls\":[",
+             (result.pottedMask & 1u) ? "true" : "false", result.nextPlayer, result.gameOver ? "true" : "false", result.winner);
+    out += buffer;
+    for (int i = 0; i < NUM_BALLS; i++) {
+        if (i > 0) out += ',';
+        if (!result.active[i]) {
+            out += "null";
+            continue;
+        }
+        snprintf(buffer, sizeof(buffer), "[%.9g,%.9g]", result.x[i], result.y[i]);
+        out += buffer;
+    }
+    out += "]}\n";
+}
+
+template <typename T>
+T loadLittleEndian(const char* bytes) {
+    T value;
+    memcpy(&value, bytes, sizeof(T)); // Host is little-endian (x86/ARM)
+    return value;
+}
+
+template <typename T>
+void appendLittleEndian(std::string& out, T value) {
+    out.append((const char*)&value, sizeof(T));
+}
+
+// Payload: u64 id, f32 cueAngle, f32 cuePower, u8 currentPlayer,
+// u8 flags (1 = ball types assigned, 2 = player 1 has solids, 4 = positions present),
+// u16 reserved, 16 x (f32 x, f32 y), u16 active mask
+void readBinaryRequest(const std::string& payload, ShotRequest& request) {
+    request = ShotRequest();
+    if (payload.size() < BINARY_REQUEST_SIZE) {
+        request.error = "short frame";
+        if (payload.size() >= 8) request.id = loadLittleEndian<uint64_t>(payload.data());
+        return;
+    }
+
+    const char* p = payload.data();
+    request.id = loadLittleEndian<uint64_t>(p);
+    request.cueAngle = loadLittleEndian<float>(p + 8);
+    request.cuePower = loadLittleEndian<float>(p + 12);
+    request.currentPlayer = (uint8_t)p[16];
+    uint8_t flags = (uint8_t)p[17];
+    request.ballTypeAssigned = (flags & 1) != 0;
+    request.player1Solids = (flags & 2) != 0;
+    request.hasPositions = (flags & 4) != 0;
+    uint16_t activeMask = loadLittleEndian<uint16_t>(p + 20 + NUM_BALLS * 8);
+    for (int i = 0; i < NUM_BALLS; i++) {
+        request.x[i] = loadLittleEndian<float>(p + 20 + i * 8);
+        request.y[i] = loadLittleEndian<float>(p + 24 + i * 8);
+        request.active[i] = (activeMask & (1u << i)) != 0;
+    }
+}
+
+// Payload: u64 id, u32 steps, u16 potted mask, u16 active mask,
+// u8 flags (1 = settled, 2 = foul, 4 = game over, 8 = error), u8 next player, i8 winner,
+// u8 reserved, 16 x (f32 x, f32 y)
+void appendBinaryResult(std::string& out, const ShotResult& result) {
+    uint16_t activeMask = 0;
+    for (int i = 0; i < NUM_BALLS; i++) {
+        if (result.active[i]) activeMask |= (uint16_t)(1u << i);
+    }
+    uint8_t flags = (result.settled ? 1 : 0) | ((result.pottedMask & 1u) ? 2 : 0) | (result.gameOver ? 4 : 0) |
+                    (result.error.empty() ? 0 : 8);
+
+    appendLittleEndian<uint32_t>(out, 148);
+    appendLittleEndian<uint64_t>(out, result.id);
+    appendLittleEndian<uint32_t>(out, (uint32_t)result.steps);
+    appendLittleEndian<uint16_t>(out, (uint16_t)result.pottedMask);
+    appendLittleEndian<uint16_t>(out, activeMask);
+    appendLittleEndian<uint8_t>(out, flags);
+    appendLittleEndian<uint8_t>(out, (uint8_t)result.nextPlayer);
+    appendLittleEndian<int8_t>(out, (int8_t)result.winner);
+    appendLittleEndian<uint8_t>(out, 0);
+    for (int i = 0; i < NUM_BALLS; i++) {
+        appendLittleEndian<float>(out, result.x[i]);
+        appendLittleEndian<float>(out, result.y[i]);
+    }
+}
+
+// A group of queries evaluated together; workers claim SHOT_CHUNK queries at a time
+struct ShotBatch {
+    std::vector<ShotRequest> requests;
+    std::vector<ShotResult> results;
+    size_t claimed = 0;  // Guarded by the pool mutex
+    size_t finished = 0; // Guarded by the pool mutex
+};
+
+class ShotWorkerPool {
+public:
+    explicit ShotWorkerPool(int threadCount) {
+        for (int i = 0; i < threadCount; i++) {
+            workers.emplace_back(&ShotWorkerPool::workerLoop, this);
+        }
+    }
+
+    ~ShotWorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        workAvailable.notify_all();
+        for (std::thread& worker : workers) worker.join();
+    }
+
+    void submit(ShotBatch* batch) {
+        batch->claimed = 0;
+        batch->finished = 0;
+        batch->results.resize(batch->requests.size());
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queue.push_back(batch);
+        }
+        workAvailable.notify_all();
+    }
+
+    void wait(ShotBatch* batch) {
+        std::unique_lock<std::mutex> lock(mutex);
+        batchFinished.wait(lock, [batch] { return batch->finished == batch->requests.size(); });
+    }
+
+private:
+    void workerLoop() {
+        GameState rack;
+        initializeGame(rack);
+        GameState g = rack;
+
+        for (;;) {
+            ShotBatch* batch;
+            size_t begin, end;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                workAvailable.wait(lock, [this] { return stopping || !queue.empty(); });
+                if (queue.empty()) return;
+                batch = queue.front();
+                begin = batch->claimed;
+                end = std::min(begin + SHOT_CHUNK, batch->requests.size());
+                batch->claimed = end;
+                if (end == batch->requests.size()) queue.pop_front();
+            }
+
+            for (size_t i = begin; i < end; i++) {
+                evaluateShot(batch->requests[i], rack, g, batch->results[i]);
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            batch->finished += end - begin;
+            if (batch->finished == batch->requests.size()) batchFinished.notify_all();
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable workAvailable;
+    std::condition_variable batchFinished;
+    std::deque<ShotBatch*> queue;
+    bool stopping = false;
+    std::vector<std::thread> workers;
+};
+
+// True if reading stdin would not block
+bool inputPending() {
+    if (std::cin.rdbuf()->in_avail() > 0) return true;
+    pollfd stdinPoll = { 0, POLLIN, 0 };
+    return poll(&stdinPoll, 1, 0) > 0;
+}
+
+// Fill a batch from stdin; stops early when input stalls so interactive callers get answers.
+// Returns false once stdin is exhausted (or a binary frame is unreadable).
+bool readShotBatch(ShotBatch& batch, size_t batchSize, bool binary, std::string& buffer) {
+    while (batch.requests.size() < batchSize) {
+        if (!batch.requests.empty() && !inputPending()) return true;
+
+        if (binary) {
+            char header[4];
+            if (!std::cin.read(header, 4)) return false;
+            uint32_t length = loadLittleEndian<uint32_t>(header);
+            if (length > MAX_FRAME_SIZE) {
+                std::cerr << "Frame of " << length << " bytes exceeds the limit; stopping" << std::endl;
+                return false;
+            }
+            buffer.resize(length);
+            if (!std::cin.read(&buffer[0], length)) {
+                std::cerr << "Truncated frame at end of input" << std::endl;
+                return false;
+            }
+            batch.requests.emplace_back();
+            readBinaryRequest(buffer, batch.requests.back());
+        }
+        else {
+            if (!std::getline(std::cin, buffer)) return false;
+            if (buffer.find_first_not_of(" \t\r") == std::string::npos) continue; // Blank line
+            batch.requests.emplace_back();
+            parseJsonRequest(buffer, batch.requests.back());
+        }
+    }
+    return true;
+}
+
+int runShotService(int argc, char** argv) {
+    bool binary = false;
+    int threadCount = (int)std::max(1u, std::thread::hardware_concurrency());
+    size_t batchSize = 256;
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--binary") binary = true;
+        else if (arg == "--threads" && i + 1 < argc) threadCount = std::max(1, atoi(argv[++i]));
+        else if (arg == "--batch" && i + 1 < argc) batchSize = (size_t)std::max(1, atoi(argv[++i]));
+        else {
+            std::cerr << "Usage: " << argv[0] << " --serve [--binary] [--threads N] [--batch N]" << std::endl;
+            return 2;
+        }
+    }
+
+    std::ios::sync_with_stdio(false);
+    std::cin.tie(nullptr);
+
+    // At most maxInFlight batches exist at once, so memory stays flat however long the stream is
+    const size_t maxInFlight = 4;
+    ShotWorkerPool pool(threadCount);
+    std::deque<std::unique_ptr<ShotBatch>> inFlight;
+    std::vector<std::unique_ptr<ShotBatch>> spare;
+    std::string line, out;
+    bool more = true;
+
+    while (more || !inFlight.empty()) {
+        if (more) {
+            std::unique_ptr<ShotBatch> batch;
+            if (spare.empty()) batch.reset(new ShotBatch);
+            else {
+                batch = std::move(spare.back());
+                spare.pop_back();
+            }
+            batch->requests.clear();
+            more = readShotBatch(*batch, batchSize, binary, line);
+            if (batch->requests.empty()) spare.push_back(std::move(batch));
+            else {
+                pool.submit(batch.get());
+                inFlight.push_back(std::move(batch));
+            }
+        }
+
+        // Write finished batches in order: when the window is full, at end of input,
+        // or when the client is waiting on us
+        bool drain = !more || !inputPending();
+        while (!inFlight.empty() && (drain || inFlight.size() >= maxInFlight)) {
+            ShotBatch* batch = inFlight.front().get();
+            pool.wait(batch);
+            out.clear();
+            for (const ShotResult& result : batch->results) {
+                if (binary) appendBinaryResult(out, result);
+                else appendJsonResult(out, result);
+            }
+            std::cout.write(out.data(), out.size());
+            spare.push_back(std::move(inFlight.front()));
+            inFlight.pop_front();
+            if (!drain) break;
+        }
+        std::cout.flush();
+        if (!std::cout) return 1; // Reader went away
+    }
+    return 0;
+}
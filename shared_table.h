@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "physics.h"
+
+// Live table for other local processes (stream overlays, scoreboards, analytics). After every
+// step the simulation thread writes a fixed-layout SharedTable into a POSIX shared memory
+// segment under a sequence lock: sequence goes odd, the state is copied in,
+// sequence goes even again. A reader copies the state out between two loads of sequence and
+// keeps the copy only if both loads saw the same even value, otherwise it copies again. Readers
+// map the segment read-only and never write to it, so there can be any number of them and
+// none can hold up the game; reading takes no system calls once the segment is mapped.
+// Ball positions are the ones on screen, so they follow the shot animation; scores, player
+// and game over change when a shot's animation ends. The segment is SHARED_TABLE_NAME, or while
+// another game (or a crashed one) holds that, SHARED_TABLE_NAME-<pid>: the game only ever writes
+// to a segment it created, and tells which one on stderr. Layout (native byte order, no padding):
+//   0  u32 magic 'POOL'   4  u32 version   8  u32 size of SharedTable   12 u32 reserved
+//   16 u64 sequence       24 SharedTableState (see below)
+const char* const SHARED_TABLE_NAME = "/pool-table";
+const uint32_t SHARED_TABLE_MAGIC = 0x4c4f4f50; // "POOL" read as bytes
+const uint32_t SHARED_TABLE_VERSION = 1;
+
+struct SharedBall {
+    float x, y;
+    float vx, vy;
+    int32_t active;
+    int32_t player; // 1 or 2 once groups are assigned; -1 solids, -2 stripes before; 0 the cue ball and black
+};
+
+struct SharedTableState {
+    uint64_t step;          // Simulation steps since the segment was created
+    int64_t publishedNanos; // CLOCK_MONOTONIC, to tell a stalled game from a quiet table
+    int32_t player1Score;
+    int32_t player2Score;
+    int32_t currentPlayer;
+    int32_t gameOver;
+    int32_t winner;
+    int32_t shots;
+    int32_t ballsMoving;
+    int32_t ballCount;
+    SharedBall balls[NUM_BALLS];
+};
+
+struct SharedTable {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;
+    uint32_t reserved;
+    std::atomic<uint64_t> sequence; // Odd while a write is in progress
+    SharedTableState state;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "the sequence must work across processes");
+static_assert(offsetof(SharedTable, state) == 24 && sizeof(SharedTable) == 24 + 48 + NUM_BALLS * 24, "SharedTable layout is published");
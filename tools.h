@@ -0,0 +1,68 @@
+// Headless modes, dispatched from main() on argv[1] before any window opens
+#pragma once
+
+#include <random>
+
+#include "physics.h"
+
+int runShotService(int argc, char** argv);        // --serve
+int runCollisionBenchmark(int argc, char** argv); // --bench-collisions
+int runAimBenchmark(int argc, char** argv);       // --bench-aim
+int runCoarseBenchmark(int argc, char** argv);    // --bench-coarse
+int runHistoryBenchmark(int argc, char** argv);   // --bench-history
+int runHeatmap(int argc, char** argv);            // --heatmap
+int runCalibration(int argc, char** argv);        // --calibrate
+int runRecordReference(int argc, char** argv);    // --record-reference
+int runExport(int argc, char** argv);             // --export
+int runVerifyExport(int argc, char** argv);       // --verify-export
+int runMatchHost(int argc, char** argv);          // --host
+int runWatch(int argc, char** argv);              // --watch
+
+// Random play for the offline tools. Consecutive random shots make random games, so layouts go
+// well beyond the break; a finished game is racked again, keeping the table's physics. Each tool
+// seeds its own RandomPlay (one per worker thread) and only adds what it does around a shot.
+class RandomPlay {
+public:
+    explicit RandomPlay(unsigned seed, float minPower = 0.2f) : random(seed), angle(-PI, PI), power(minPower, 1.0f) {}
+
+    // Rack again if the last game is over; true if it was
+    bool continueGame(GameState& g) {
+        if (!g.gameOver) return false;
+        initializeGame(g);
+        return true;
+    }
+
+    // Shoot at a random power, in a random direction or the one given
+    ShotRecord shoot(GameState& g) {
+        float cueAngle = angle(random);
+        return shoot(g, cueAngle);
+    }
+
+    ShotRecord shoot(GameState& g, float cueAngle) {
+        applyShot(g, cueAngle, power(random) * g.maxCuePower);
+        return { g.cueAngle, g.cuePower };
+    }
+
+    // One shot played to rest through update(): beforeShot(g) sees the table about to be shot,
+    // afterStep(g) every step of the shot
+    template <typename BeforeShot, typename AfterStep>
+    ShotRecord playShot(GameState& g, BeforeShot beforeShot, AfterStep afterStep) {
+        continueGame(g);
+        beforeShot(g);
+        ShotRecord shot = shoot(g);
+        for (int step = 0; step < MAX_SHOT_STEPS && g.ballsMoving && !g.gameOver; step++) {
+            update(g);
+            afterStep(g);
+        }
+        return shot;
+    }
+
+    std::mt19937 random; // Also for the tool's own draws
+
+private:
+    std::uniform_real_distribution<float> angle;
+    std::uniform_real_distribution<float> power;
+};
+
+// No-op hook for RandomPlay::playShot()
+inline void ignoreTable(const GameState&) {}
@@ -0,0 +1,72 @@
+#include "shared_table.h"
+#include "tools.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+// Consistent copy of a mapped table's state; false if it never settled within the given tries
+bool readSharedTable(const SharedTable* table, SharedTableState& state, int tries = 1000) {
+    for (int attempt = 0; attempt < tries; attempt++) {
+        uint64_t before = table->sequence.load(std::memory_order_acquire);
+        if (before & 1) continue;
+        memcpy(&state, &table->state, sizeof(state));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (table->sequence.load(std::memory_order_relaxed) == before) return true;
+    }
+    return false;
+}
+
+// Example reader (game --watch [hz] [name]): a text scoreboard of the running game, by default
+// the one publishing to SHARED_TABLE_NAME
+int runWatch(int argc, char** argv) {
+    double rate = argc > 2 ? std::max(0.1, atof(argv[2])) : 2.0;
+    std::string name = argc > 3 ? argv[3] : SHARED_TABLE_NAME;
+    if (name[0] != '/') name = "/" + name;
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        std::cerr << "No game running (" << name << ": " << strerror(errno) << ")" << std::endl;
+        return 1;
+    }
+    // Mapping past the end of a segment still being sized would fault on the first read
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(SharedTable)) {
+        close(fd);
+        std::cerr << name << " is not a version " << SHARED_TABLE_VERSION << " table" << std::endl;
+        return 1;
+    }
+    void* mapping = mmap(nullptr, sizeof(SharedTable), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        std::cerr << "Could not map " << name << ": " << strerror(errno) << std::endl;
+        return 1;
+    }
+    const SharedTable* table = static_cast<const SharedTable*>(mapping);
+    if (table->magic != SHARED_TABLE_MAGIC || table->version != SHARED_TABLE_VERSION || table->size != sizeof(SharedTable)) {
+        std::cerr << name << " is not a version " << SHARED_TABLE_VERSION << " table" << std::endl;
+        return 1;
+    }
+
+    SharedTableState state;
+    while (true) {
+        if (readSharedTable(table, state)) {
+            int onTable = 0;
+            for (int i = 1; i < state.ballCount; i++) onTable += state.balls[i].active != 0;
+            std::cout << "step " << state.step << "  Player 1: " << state.player1Score << " | Player 2: " << state.player2Score
+                      << "  shots " << state.shots << "  " << onTable << " balls on the table  ";
+            if (state.gameOver) std::cout << "game over, player " << state.winner << " wins";
+            else std::cout << "player " << state.currentPlayer << (state.ballsMoving ? " shooting" : " to play")
+                           << "  cue ball " << state.balls[0].x << ", " << state.balls[0].y;
+            std::cout << std::endl;
+        }
+        std::this_thread::sleep_for(std::chrono::duration<double>(1.0 / rate));
+    }
+}